@@ -253,6 +253,30 @@ struct __kh_fgFunctionMap_t;
 extern __inline struct __kh_fgFunctionMap_t* fgFunctionMap_init();
 extern void fgFunctionMap_destroy(struct __kh_fgFunctionMap_t*);
 
+// Maps each message type to the most derived handler that actually does something with it.
+typedef struct _FG_DISPATCH_TABLE {
+  fgMessage message;
+  fgMessage handlers[FG_CUSTOMEVENT];
+} fgDispatchTable;
+
+const fgDispatchTable* fgDispatch_Get(fgMessage message);
+#ifdef BSS_DEBUG
+size_t fgDispatch_Verify(fgElement* self, const FG_Msg* msg, fgMessage handler);
+#endif
+
+BSS_FORCEINLINE size_t fgDispatchMessage(fgElement* self, const FG_Msg* msg)
+{
+  if(msg->type >= FG_CUSTOMEVENT)
+    return (*self->message)(self, msg);
+  if(!self->dispatch || self->dispatch->message != self->message) // Destroy functions swap message out for the parent's, so this can change
+    self->dispatch = fgDispatch_Get(self->message);
+#ifdef BSS_DEBUG
+  if(self->dispatch->handlers[msg->type] != self->message)
+    return fgDispatch_Verify(self, msg, self->dispatch->handlers[msg->type]);
+#endif
+  return (*self->dispatch->handlers[msg->type])(self, msg);
+}
+
 template<FG_MSGTYPE type, typename... Args>
 static inline size_t _sendmsg(fgElement* self, Args... args)
 {
@@ -272,7 +296,68 @@ static inline size_t _sendsubmsg(fgElement* self, unsigned short sub, Args... ar
   return (*fgroot_instance->backend.behaviorhook)(self, &msg);
 }
 
-FG_EXTERN bss_util::cHash<std::pair<fgElement*, unsigned short>, fgListener> fgListenerHash;
+// Flat open-addressing table mapping (element, message type) to its listeners. The first listener is stored inline, so the common case
+// costs a single probe with no indirection. Additional listeners on the same key spill into a separately allocated array.
+struct fgListenerTable
+{
+  struct Entry
+  {
+    fgElement* element; // NULL marks an empty slot
+    unsigned short type;
+    unsigned short count;
+    fgListener first;
+    fgListener* rest; // count - 1 listeners that were added after first
+  };
+
+  fgListenerTable() : _entries(0), _capacity(0), _used(0), _maxtype(0) {}
+  ~fgListenerTable();
+  void Insert(fgElement* element, unsigned short type, fgListener listener);
+  void RemoveAll(fgElement* element, unsigned long long mask); // mask is the element's listener bitmask, which tells us which types to probe for.
+  BSS_FORCEINLINE const Entry* Find(fgElement* element, unsigned short type) const
+  {
+    if(!_used)
+      return 0;
+    for(size_t i = _hash(element, type) & (_capacity - 1);; i = (i + 1) & (_capacity - 1))
+    {
+      if(!_entries[i].element)
+        return 0;
+      if(_entries[i].element == element && _entries[i].type == type)
+        return _entries + i;
+    }
+  }
+  BSS_FORCEINLINE void Call(fgElement* element, const FG_Msg* msg) const
+  {
+    const Entry* e = Find(element, msg->type);
+    if(!e)
+      return;
+    if(e->count > 1)
+      _callall(e, element, msg);
+    else
+    {
+      fgListener f = e->first; // A listener can add or remove listeners, which moves entries around, so never touch e after calling one.
+      f(element, msg);
+    }
+  }
+
+protected:
+  BSS_FORCEINLINE static size_t _hash(fgElement* element, unsigned short type)
+  {
+    size_t h = (((size_t)element) >> 4) ^ (((size_t)type) << 16) ^ type;
+    h *= (size_t)0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+  }
+  void _remove(size_t i);
+  bool _grow(); // Returns false if the larger table couldn't be allocated, leaving the old one in place.
+  static void _callall(const Entry* e, fgElement* element, const FG_Msg* msg);
+
+  Entry* _entries;
+  size_t _capacity; // Always a power of two
+  size_t _used;
+  unsigned short _maxtype; // Largest type ever inserted, which bounds how many types RemoveAll has to check for each bit in the mask.
+};
+
+FG_EXTERN fgListenerTable fgListenerHash;
+BSS_FORCEINLINE unsigned long long fgListenerBit(unsigned short type) { return 1ULL << (type & 63); }
 
 static inline FG_UINT fgStyleGetMask() { return 0; }
 
@@ -17,7 +17,10 @@ const fgColor fgColor_WHITE = { 0xFFFFFFFF };
 const CRect CRect_EMPTY = { 0,0,0,0,0,0,0,0 };
 const AbsVec AbsVec_EMPTY = { 0,0 };
 const fgIntVec fgIntVec_EMPTY = { 0,0 };
-bss_util::cHash<std::pair<fgElement*, unsigned short>, fgListener> fgListenerHash;
+#ifdef BSS_DEBUG
+fgLeakTracker fgLeakTracker::Tracker; // Defined before anything that allocates through it, so it's destroyed after them and doesn't report their memory as leaked
+#endif
+fgListenerTable fgListenerHash;
 bss_util::cHash<char*> fgStringAllocHash;
 bss_util::cHashBase<const char*, size_t, true, bss_util::KH_POINTER_HASHFUNC<const char* const&>, bss_util::KH_INT_EQUALFUNC<const char*>> fgStringRefHash;
 
@@ -25,9 +28,123 @@ static_assert(sizeof(unsigned int) == sizeof(fgColor), "ERROR: fgColor not size
 static_assert(sizeof(FG_Msg) <= sizeof(uint64_t) * 3, "FG_Msg is too big!");
 static_assert(sizeof(FG_Msg) == sizeof(void*)*2 + sizeof(uint32_t)*2, "FG_Msg is not 16!");
 
-#ifdef BSS_DEBUG
-fgLeakTracker fgLeakTracker::Tracker;
-#endif
+fgListenerTable::~fgListenerTable()
+{
+  for(size_t i = 0; i < _capacity; ++i)
+    if(_entries[i].element && _entries[i].rest)
+      fgfree(_entries[i].rest, __FILE__, __LINE__);
+  if(_entries)
+    fgfree(_entries, __FILE__, __LINE__);
+}
+
+void fgListenerTable::Insert(fgElement* element, unsigned short type, fgListener listener)
+{
+  if((_used + 1) * 2 > _capacity && !_grow() && _used + 1 >= _capacity) // Keep the load factor under 50% so probes stay short. If we can't, at least one slot must stay empty to end probes.
+    return;
+  if(type > _maxtype)
+    _maxtype = type;
+
+  size_t i = _hash(element, type) & (_capacity - 1);
+  while(_entries[i].element)
+  {
+    Entry& e = _entries[i];
+    if(e.element == element && e.type == type)
+    {
+      fgListener* rest = fgmalloc<fgListener>(e.count, __FILE__, __LINE__);
+      if(!rest)
+        return;
+      if(e.rest != 0)
+      {
+        MEMCPY(rest, e.count * sizeof(fgListener), e.rest, (e.count - 1) * sizeof(fgListener));
+        fgfree(e.rest, __FILE__, __LINE__);
+      }
+      rest[e.count - 1] = listener;
+      e.rest = rest;
+      ++e.count;
+      return;
+    }
+    i = (i + 1) & (_capacity - 1);
+  }
+
+  Entry& e = _entries[i];
+  e.element = element;
+  e.type = type;
+  e.count = 1;
+  e.first = listener;
+  e.rest = 0;
+  ++_used;
+}
+
+void fgListenerTable::RemoveAll(fgElement* element, unsigned long long mask)
+{
+  for(unsigned short bit = 0; mask != 0 && bit < 64; ++bit, mask >>= 1)
+  {
+    if(!(mask & 1))
+      continue;
+    for(size_t type = bit; type <= _maxtype; type += 64) // Types that share a bit in the mask differ by multiples of 64
+    {
+      const Entry* e = Find(element, (unsigned short)type);
+      if(e)
+        _remove(e - _entries);
+    }
+  }
+}
+
+void fgListenerTable::_remove(size_t i)
+{
+  if(_entries[i].rest)
+    fgfree(_entries[i].rest, __FILE__, __LINE__);
+
+  // Shift any displaced entries back into the hole so lookups never need tombstones
+  size_t mask = _capacity - 1;
+  for(size_t j = (i + 1) & mask; _entries[j].element; j = (j + 1) & mask)
+  {
+    size_t k = _hash(_entries[j].element, _entries[j].type) & mask;
+    if((j > i) ? (k <= i || k > j) : (k <= i && k > j))
+    {
+      _entries[i] = _entries[j];
+      i = j;
+    }
+  }
+
+  _entries[i].element = 0;
+  _entries[i].rest = 0;
+  --_used;
+}
+
+void fgListenerTable::_callall(const Entry* e, fgElement* element, const FG_Msg* msg)
+{
+  unsigned short count = e->count;
+  DYNARRAY(fgListener, list, count); // Snapshot the listeners first, because any of them can invalidate e or e->rest
+  list[0] = e->first;
+  MEMCPY(list + 1, (count - 1) * sizeof(fgListener), e->rest, (count - 1) * sizeof(fgListener));
+  for(unsigned short i = 0; i < count; ++i)
+    list[i](element, msg);
+}
+
+bool fgListenerTable::_grow()
+{
+  size_t capacity = !_capacity ? 16 : (_capacity << 1);
+  Entry* entries = fgmalloc<Entry>(capacity, __FILE__, __LINE__);
+  if(!entries)
+    return false;
+  memset(entries, 0, capacity * sizeof(Entry));
+  for(size_t i = 0; i < _capacity; ++i)
+  {
+    if(!_entries[i].element)
+      continue;
+    size_t j = _hash(_entries[i].element, _entries[i].type) & (capacity - 1);
+    while(entries[j].element)
+      j = (j + 1) & (capacity - 1);
+    entries[j] = _entries[i];
+  }
+
+  if(_entries)
+    fgfree(_entries, __FILE__, __LINE__);
+  _entries = entries;
+  _capacity = capacity;
+  return true;
+}
 
 AbsVec ResolveVec(const CVec* v, const AbsRect* last)
 {
@@ -0,0 +1,175 @@
+// Copyright 2017 Black Sphere Studios
+// For conditions of distribution and use, see copyright notice in "feathergui.h"
+
+#include "fgAnimation.h"
+#include "fgRoot.h"
+#include "feathercpp.h"
+#include "bss-util/bss_sse.h"
+
+struct fgTweenWrite
+{
+  fgElement* target;
+  unsigned short property;
+  FG_Msg msg;
+  float value[8];
+};
+
+static bss_util::cDynArray<fgTweenWrite> fgAnimation_Writes; // Values waiting to be sent during fgAnimation_Update
+
+static void fgAnimation_Load(unsigned short property, const void* src, float* out)
+{
+  switch(property)
+  {
+  case FGANIMATION_AREA:
+    memcpy(out, src, sizeof(CRect));
+    break;
+  case FGANIMATION_MARGIN:
+  case FGANIMATION_PADDING:
+    memcpy(out, src, sizeof(AbsRect));
+    break;
+  case FGANIMATION_COLOR:
+    for(size_t i = 0; i < 4; ++i)
+      out[i] = ((const fgColor*)src)->colors[i];
+    break;
+  }
+}
+
+static void fgAnimation_Current(fgElement* target, unsigned short property, unsigned short subtype, float* out)
+{
+  fgColor color;
+  switch(property)
+  {
+  case FGANIMATION_AREA: fgAnimation_Load(property, &target->transform.area, out); break;
+  case FGANIMATION_MARGIN: fgAnimation_Load(property, &target->margin, out); break;
+  case FGANIMATION_PADDING: fgAnimation_Load(property, &target->padding, out); break;
+  case FGANIMATION_COLOR:
+    color.color = (unsigned int)_sendsubmsg<FG_GETCOLOR>(target, subtype);
+    fgAnimation_Load(property, &color, out);
+    break;
+  }
+}
+
+static float fgAnimation_Ease(unsigned char easing, float t)
+{
+  switch(easing)
+  {
+  case FGANIMATION_EASEIN: return t*t;
+  case FGANIMATION_EASEOUT: return t*(2.0f - t);
+  case FGANIMATION_EASEINOUT: return (t < 0.5f) ? (2.0f*t*t) : (-1.0f + (4.0f - 2.0f*t)*t);
+  }
+  return t;
+}
+
+void fgAnimate(fgElement* target, unsigned short property, unsigned short subtype, const void* end, float duration, unsigned char easing)
+{
+  assert(target != 0 && end != 0);
+  bss_util::cDynArray<fgTween>& tweens = (bss_util::cDynArray<fgTween>&)fgroot_instance->animations;
+
+  fgTween tween = { 0 };
+  tween.target = target;
+  tween.start = fgroot_instance->time;
+  tween.duration = duration;
+  tween.property = property;
+  tween.subtype = subtype;
+  tween.easing = easing;
+  float to[8] = { 0 };
+  fgAnimation_Current(target, property, subtype, tween.from);
+  fgAnimation_Load(property, end, to);
+  for(size_t i = 0; i < 8; ++i)
+  {
+    tween.delta[i] = to[i] - tween.from[i];
+    tween.value[i] = tween.from[i];
+  }
+
+  size_t insert = tweens.Length();
+  for(size_t i = 0; i < tweens.Length(); ++i)
+  {
+    if(tweens[i].target != target)
+      continue;
+    if(tweens[i].property == property && tweens[i].subtype == subtype)
+    {
+      tweens[i] = tween;
+      return;
+    }
+    insert = i + 1; // Keep every tween on the same target together, so fgAnimation_Update can batch their messages
+  }
+  tweens.Insert(tween, insert);
+}
+
+void fgAnimation_Stop(fgElement* target, unsigned short property)
+{
+  bss_util::cDynArray<fgTween>& tweens = (bss_util::cDynArray<fgTween>&)fgroot_instance->animations;
+  for(size_t i = tweens.Length(); i-- > 0;)
+    if(tweens[i].target == target && (property == (unsigned short)-1 || tweens[i].property == property))
+      tweens.Remove(i);
+  for(size_t i = 0; i < fgAnimation_Writes.Length(); ++i) // If this is called while values are being sent, make sure none are sent to target afterwards
+    if(fgAnimation_Writes[i].target == target && (property == (unsigned short)-1 || fgAnimation_Writes[i].property == property))
+      fgAnimation_Writes[i].target = 0;
+}
+
+void fgAnimation_Update(fgVectorTween* tweens, double time)
+{
+  if(!tweens->l)
+    return;
+  fgTween* p = tweens->p;
+  size_t n = tweens->l;
+
+  // Interpolate everything in one pass before any messages are sent
+  for(size_t i = 0; i < n; ++i)
+  {
+    float t = (p[i].duration > 0.0f) ? (float)((time - p[i].start) / p[i].duration) : 1.0f;
+    sseVec e(fgAnimation_Ease(p[i].easing, (t < 0.0f) ? 0.0f : (t > 1.0f) ? 1.0f : t));
+    (sseVec(BSS_UNALIGNED<const float>(p[i].from)) + (sseVec(BSS_UNALIGNED<const float>(p[i].delta)) * e)) >> BSS_UNALIGNED<float>(p[i].value);
+    (sseVec(BSS_UNALIGNED<const float>(p[i].from + 4)) + (sseVec(BSS_UNALIGNED<const float>(p[i].delta + 4)) * e)) >> BSS_UNALIGNED<float>(p[i].value + 4);
+  }
+
+  // Queue up the messages and drop finished tweens, so handlers are free to start or stop animations while the values are sent
+  fgAnimation_Writes.Clear();
+  size_t j = 0;
+  for(size_t i = 0; i < n; ++i)
+  {
+    fgTweenWrite write = { p[i].target, p[i].property };
+    memcpy(write.value, p[i].value, sizeof(write.value));
+    write.msg.subtype = p[i].subtype;
+    switch(p[i].property)
+    {
+    case FGANIMATION_AREA: write.msg.type = FG_SETAREA; write.msg.subtype = 0; break;
+    case FGANIMATION_MARGIN: write.msg.type = FG_SETMARGIN; write.msg.subtype = 0; break;
+    case FGANIMATION_PADDING: write.msg.type = FG_SETPADDING; write.msg.subtype = 0; break;
+    case FGANIMATION_COLOR:
+    {
+      fgColor color;
+      for(size_t k = 0; k < 4; ++k)
+        color.colors[k] = (unsigned char)(p[i].value[k] + 0.5f);
+      write.msg.type = FG_SETCOLOR;
+      write.msg.u = color.color;
+      break;
+    }
+    }
+    fgAnimation_Writes.Add(write);
+    if(time < p[i].start + p[i].duration)
+      p[j++] = p[i];
+  }
+  tweens->l = j;
+
+  // Every value for the same element goes out in a single batch, so it only moves, lays out and redraws once.
+  FG_Msg msgs[8];
+  for(size_t i = 0; i < fgAnimation_Writes.Length();)
+  {
+    fgElement* target = fgAnimation_Writes[i].target;
+    size_t m = 0;
+    for(; i < fgAnimation_Writes.Length() && fgAnimation_Writes[i].target == target && m < 8; ++i, ++m)
+    {
+      msgs[m] = fgAnimation_Writes[i].msg;
+      if(msgs[m].type != FG_SETCOLOR)
+        msgs[m].p = fgAnimation_Writes[i].value;
+    }
+    if(!target)
+      continue;
+    if(m == 1)
+      (*fgroot_instance->backend.behaviorhook)(target, msgs);
+    else
+      fgSendMsgBatch(target, msgs, m);
+  }
+  fgAnimation_Writes.Clear();
+}
@@ -161,19 +161,108 @@ void fgUserDataMapCallbacks(fgElement* self, struct __VECTOR__KeyValue* pairs)
 size_t fgBehaviorHookDefault(fgElement* self, const FG_Msg* msg)
 {
   assert(self != 0);
-  return (*self->message)(self, msg);
+  return fgDispatchMessage(self, msg);
 }
 
 size_t fgBehaviorHookListener(fgElement* self, const FG_Msg* msg)
 {
   assert(self != 0);
-  size_t ret = (*self->message)(self, msg);
-  khiter_t iter = fgListenerHash.Iterator(std::pair<fgElement*, unsigned short>(self, msg->type));
-  if(fgListenerHash.ExistsIter(iter))
-    fgListenerHash.GetValue(iter)(self, msg);
+  unsigned long long listening = self->listeners&fgListenerBit(msg->type); // Read this before dispatching, because the message can destroy self
+  size_t ret = fgDispatchMessage(self, msg);
+  if(!listening) // Most elements have no listeners, so don't bother hashing
+    return ret;
+  fgListenerHash.Call(self, msg);
   return ret;
 }
 
+struct fgMsgBatch
+{
+  fgElement* target;
+  fgMsgBatch* prev; // Enclosing batch, if this one was started while another was running
+  size_t(*behaviorhook)(fgElement* self, const FG_Msg* msg); // Hooks the outermost batch replaced, shared by every nested batch
+  void(*dirty)(fgElement* elem);
+  size_t move; // Every FG_MOVE diff the target sent itself during the batch
+  unsigned short movesub; // Subtype shared by those FG_MOVE messages, or 0 if they disagreed
+  char moved;
+  char layout;
+  size_t dirtied;
+};
+static fgMsgBatch* fgMsgBatch_Current = 0;
+
+static size_t fgBehaviorHookBatch(fgElement* self, const FG_Msg* msg)
+{
+  for(fgMsgBatch* batch = fgMsgBatch_Current; batch != 0; batch = batch->prev)
+  {
+    if(self != batch->target)
+      continue;
+    switch(msg->type)
+    {
+    case FG_MOVE:
+      if(msg->p != 0) // Only coalesce moves that originate from the target, not ones propagated from its parent or children
+        break;
+      if(batch->moved && batch->movesub != msg->subtype)
+        batch->movesub = 0;
+      else
+        batch->movesub = msg->subtype;
+      batch->move |= msg->u2;
+      batch->moved = 1;
+      return FG_ACCEPT;
+    case FG_LAYOUTCHANGE:
+      batch->layout = 1;
+      if(msg->subtype == FGELEMENT_LAYOUTREORDER) // Boxes keep their ordered array in sync through this, so it can't wait for the final reset
+        return (*fgMsgBatch_Current->behaviorhook)(self, msg);
+      return FG_ACCEPT;
+    }
+  }
+  return (*fgMsgBatch_Current->behaviorhook)(self, msg);
+}
+
+static void fgDirtyElementBatch(fgElement* elem)
+{
+  for(fgMsgBatch* batch = fgMsgBatch_Current; batch != 0; batch = batch->prev)
+    if(elem == batch->target && batch->dirtied++ > 0) // Let the first one through so the old area is still invalidated
+      return;
+  (*fgMsgBatch_Current->dirty)(elem);
+}
+
+size_t fgSendMsgBatch(fgElement* self, const FG_Msg* msgs, size_t n)
+{
+  assert(self != 0);
+  fgMsgBatch batch = { self, fgMsgBatch_Current, fgroot_instance->backend.behaviorhook, fgroot_instance->backend.fgDirtyElement, 0, 0, 0, 0, 0 };
+  if(batch.prev != 0) // Only the outermost batch installs the hooks, nested batches just push themselves onto the chain
+  {
+    batch.behaviorhook = batch.prev->behaviorhook;
+    batch.dirty = batch.prev->dirty;
+  }
+  else
+  {
+    fgroot_instance->backend.behaviorhook = &fgBehaviorHookBatch;
+    fgroot_instance->backend.fgDirtyElement = &fgDirtyElementBatch;
+  }
+  fgMsgBatch_Current = &batch;
+
+  size_t accepted = 0;
+  for(size_t i = 0; i < n; ++i)
+    if((*batch.behaviorhook)(self, msgs + i)) // The messages themselves always go through, only the notifications they cause are held back
+      ++accepted;
+
+  fgMsgBatch_Current = batch.prev;
+  if(!batch.prev)
+  {
+    fgroot_instance->backend.behaviorhook = batch.behaviorhook;
+    fgroot_instance->backend.fgDirtyElement = batch.dirty;
+  }
+
+  // These go through whatever hooks are installed now, so an enclosing batch on the same element absorbs them.
+  if(batch.dirtied > 1)
+    (*fgroot_instance->backend.fgDirtyElement)(self);
+  if(batch.moved && batch.move != 0)
+    _sendsubmsg<FG_MOVE, void*, size_t>(self, batch.movesub, 0, batch.move);
+  if(batch.layout)
+    _sendsubmsg<FG_LAYOUTCHANGE, void*, size_t>(self, FGELEMENT_LAYOUTRESET, 0, 0);
+  return accepted;
+}
+
 __inline struct __kh_fgFunctionMap_t* fgFunctionMap_init()
 {
   return kh_init_fgFunctionMap();
@@ -19,6 +19,15 @@ void fgBox_Destroy(fgBox* self)
 void fgBoxOrderedElement_Destroy(struct _FG_BOX_ORDERED_ELEMENTS_* self)
 {
   ((bss_util::cDynArray<fgElement*>&)self->ordered).~cDynArray();
+  ((bss_util::cDynArray<fgElement*>&)self->deferred).~cDynArray();
+}
+
+// Updates the back-index of every element in the ordered array from index up to, but not including, end.
+inline void fgBoxOrderedElement_Reindex(struct _FG_BOX_ORDERED_ELEMENTS_* self, size_t index, size_t end)
+{
+  for(size_t i = index; i < end; ++i)
+    if(self->ordered.p[i] != 0) // Skip holes left by a bulk removal
+      self->ordered.p[i]->orderindex = i;
 }
 
 bool BSS_FORCEINLINE checkIsOrdered(fgElement* root)
@@ -35,6 +44,88 @@ bool BSS_FORCEINLINE checkIsOrdered(fgElement* root)
   return count < 3; // If count never exceeded 2, then this matches the pattern BACKGROUND-FOREGROUND-BACKGROUND.
 }
 
+// Rebuilds the ordered array from the child list, if the children are still ordered.
+void fgBoxOrderedElement_Rebuild(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element)
+{
+  self->isordered = checkIsOrdered(element->root);
+  self->ordered.l = 0;
+  if(!self->isordered)
+    return;
+  for(fgElement* cur = element->root; cur != 0; cur = cur->next)
+  {
+    if(cur->flags&FGELEMENT_BACKGROUND)
+      continue;
+    if(cur->flags&FGELEMENT_NOCLIP)
+    {
+      self->isordered = 0;
+      self->ordered.l = 0;
+      break;
+    }
+    cur->orderindex = self->ordered.l;
+    ((bss_util::cDynArray<fgElement*>&)self->ordered).Add(cur);
+  }
+}
+
+// Finds the nearest foreground sibling in the given direction. Returns -1 if a background element was skipped to reach it, which means the ordering is broken.
+inline fgElement* fgBoxOrderedElement_Neighbor(fgElement* cur, bool forward)
+{
+  bool background = false;
+  for(cur = forward ? cur->next : cur->prev; cur != 0; cur = forward ? cur->next : cur->prev)
+  {
+    if(!(cur->flags&FGELEMENT_BACKGROUND))
+      return background ? (fgElement*)~(size_t)0 : cur;
+    background = true;
+  }
+  return 0;
+}
+
+// Updates the ordered array after a single child was moved, shifting only the entries between its old and new index.
+void fgBoxOrderedElement_Move(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element, fgElement* child)
+{
+  size_t i = child->orderindex;
+  fgElement* next = fgBoxOrderedElement_Neighbor(child, true);
+  fgElement* prev = fgBoxOrderedElement_Neighbor(child, false);
+  if(i >= self->ordered.l || self->ordered.p[i] != child || next == (fgElement*)~(size_t)0 || prev == (fgElement*)~(size_t)0)
+    return fgBoxOrderedElement_Rebuild(self, element);
+
+  size_t j = i;
+  if(next != 0) // Other children keep their relative order, so their old indices tell us where child lands
+    j = (next->orderindex > i) ? next->orderindex - 1 : next->orderindex;
+  else if(prev != 0)
+    j = (prev->orderindex > i) ? prev->orderindex : prev->orderindex + 1;
+
+  if(j < i)
+    memmove(self->ordered.p + j + 1, self->ordered.p + j, (i - j) * sizeof(fgElement*));
+  else if(j > i)
+    memmove(self->ordered.p + i, self->ordered.p + i + 1, (j - i) * sizeof(fgElement*));
+  self->ordered.p[j] = child;
+  fgBoxOrderedElement_Reindex(self, bssmin(i, j), bssmax(i, j) + 1);
+}
+
+// Rebuilds the ordered array from child onwards after a block of children was moved. Everything before child is unchanged.
+void fgBoxOrderedElement_RebuildFrom(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element, fgElement* child)
+{
+  fgElement* prev = fgBoxOrderedElement_Neighbor(child, false);
+  if(prev == (fgElement*)~(size_t)0 || (child->flags&FGELEMENT_BACKGROUND))
+    return fgBoxOrderedElement_Rebuild(self, element);
+
+  size_t i = !prev ? 0 : prev->orderindex + 1;
+  bool background = false;
+  for(fgElement* cur = child; cur != 0; cur = cur->next)
+  {
+    if(cur->flags&FGELEMENT_BACKGROUND)
+      background = true;
+    else if(background || (cur->flags&FGELEMENT_NOCLIP) || i >= self->ordered.l) // A foreground element after a background one breaks the ordering
+      return fgBoxOrderedElement_Rebuild(self, element);
+    else
+    {
+      self->ordered.p[i] = cur;
+      cur->orderindex = i++;
+    }
+  }
+  assert(i == self->ordered.l);
+}
+
 template<fgFlag FLAGS> BSS_FORCEINLINE char fgBoxVecCompare(const AbsVec& l, const AbsVec& r);
 template<> BSS_FORCEINLINE char fgBoxVecCompare<FGBOX_TILEX>(const AbsVec& l, const AbsVec& r) { return SGNCOMPARE(l.x, r.x); }
 template<> BSS_FORCEINLINE char fgBoxVecCompare<FGBOX_TILEY>(const AbsVec& l, const AbsVec& r) { return SGNCOMPARE(l.y, r.y); }
@@ -50,10 +141,15 @@ char fgOrderedCompare(const AbsRect& l, const fgElement* const& e, const AbsRect
   return fgBoxVecCompare<FLAGS&(FGBOX_TILE | FGBOX_DISTRIBUTEY)>(l.topleft, r.bottomright);
 }
 template<fgFlag FLAGS>
-inline fgElement* fgOrderedGet(struct _FG_BOX_ORDERED_ELEMENTS_* self, const AbsRect* area, const AbsRect* cache)
+inline size_t fgOrderedIndex(struct _FG_BOX_ORDERED_ELEMENTS_* self, const AbsRect* area, const AbsRect* cache)
 {
   size_t r = bss_util::binsearch_aux_t<const fgElement*, AbsRect, size_t, &bss_util::CompT_EQ<char>, 1, const AbsRect*>::template binsearch_near<&fgOrderedCompare<FLAGS>>(self->ordered.p, *area, 0, self->ordered.l, cache);
-  return (r >= self->ordered.l) ? self->ordered.p[0] : self->ordered.p[r];
+  return (r >= self->ordered.l) ? 0 : r;
+}
+template<fgFlag FLAGS>
+inline fgElement* fgOrderedGet(struct _FG_BOX_ORDERED_ELEMENTS_* self, const AbsRect* area, const AbsRect* cache)
+{
+  return self->ordered.p[fgOrderedIndex<FLAGS>(self, area, cache)];
 }
 template<fgFlag FLAGS>
 BSS_FORCEINLINE fgElement* fgBoxOrder(fgElement* self, const AbsRect* area, const AbsRect* cache) { return fgOrderedGet<FLAGS>(&((fgBox*)self)->order, area, cache); }
@@ -134,6 +230,87 @@ size_t fgBox_Message(fgBox* self, const FG_Msg* msg)
   return fgBoxOrderedElement_Message(&self->order, msg, *self, (fgMessage)&fgScrollbar_Message);
 }
 
+size_t fgBoxOrderedElement_GetVisible(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgFlag flags, const AbsRect* area, const AbsRect* cache)
+{
+  if(!self->isordered || !self->ordered.l)
+    return 0;
+  switch(flags&(FGBOX_TILE | FGBOX_DISTRIBUTEY))
+  {
+  default:
+  case FGBOX_TILEX: return fgOrderedIndex<FGBOX_TILEX>(self, area, cache);
+  case FGBOX_TILEY: return fgOrderedIndex<FGBOX_TILEY>(self, area, cache);
+  case FGBOX_TILE: return fgOrderedIndex<FGBOX_TILE>(self, area, cache);
+  case FGBOX_TILE | FGBOX_DISTRIBUTEY: return fgOrderedIndex<FGBOX_TILE | FGBOX_DISTRIBUTEY>(self, area, cache);
+  }
+}
+
+void fgBoxOrderedElement_BeginBatch(struct _FG_BOX_ORDERED_ELEMENTS_* self, size_t reserve)
+{
+  if(self->isordered)
+    ((bss_util::cDynArray<fgElement*>&)self->ordered).Reserve(self->ordered.l + reserve);
+  ++self->batch;
+}
+
+void fgBoxOrderedElement_EndBatch(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element)
+{
+  assert(self->batch > 0);
+  if(self->batch == 1) // Layout changes are still suspended while the children added during the batch get their skin and position
+  {
+    for(size_t i = 0; i < self->deferred.l; ++i)
+    {
+      fgElement* child = self->deferred.p[i];
+      _sendmsg<FG_SETSKIN>(child);
+      _sendsubmsg<FG_MOVE, void*, size_t>(child, FG_SETPARENT, 0, fgElement_PotentialResize(element));
+    }
+    self->deferred.l = 0;
+  }
+  if(!--self->batch)
+    fgSubMessage(element, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+}
+
+// Items are freed from the highest index down, so anything tracking them by index sees the same indices it would if they were removed
+// one at a time. Each removal only leaves a hole, and the holes are all compacted in one pass at the end.
+size_t fgBoxOrderedElement_RemoveItems(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element, fgElement** items, size_t n)
+{
+  bss_util::cDynArray<fgElement*> remove(n);
+  for(size_t i = 0; i < n; ++i)
+    if(items[i] != 0 && items[i]->parent == element)
+      remove.Add(items[i]);
+  if(self->isordered)
+    std::sort(remove.begin(), remove.end(), [](fgElement* l, fgElement* r) -> bool {
+      size_t a = (l->flags&FGELEMENT_BACKGROUND) ? 0 : l->orderindex + 1; // Background elements aren't in the array, so their order doesn't matter
+      size_t b = (r->flags&FGELEMENT_BACKGROUND) ? 0 : r->orderindex + 1;
+      return a > b;
+    });
+
+  fgBoxOrderedElement_BeginBatch(self, 0);
+  char removing = self->removing;
+  self->removing = 1;
+  for(size_t i = 0; i < remove.Length(); ++i)
+    VirtualFreeChild(remove[i]);
+  self->removing = removing;
+
+  if(!removing)
+  {
+    if(!self->isordered)
+      fgBoxOrderedElement_Rebuild(self, element);
+    else
+    {
+      size_t j = 0;
+      for(size_t i = 0; i < self->ordered.l; ++i)
+        if(self->ordered.p[i] != 0)
+        {
+          self->ordered.p[j] = self->ordered.p[i];
+          self->ordered.p[j]->orderindex = j;
+          ++j;
+        }
+      self->ordered.l = j;
+    }
+  }
+  fgBoxOrderedElement_EndBatch(self, element);
+  return remove.Length();
+}
+
 size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const FG_Msg* msg, fgElement* element, fgMessage callback)
 {
   ptrdiff_t otherint = msg->i;
@@ -143,9 +320,12 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
   {
   case FG_CONSTRUCT:
     memset(&self->ordered, 0, sizeof(fgVectorElement));
+    memset(&self->deferred, 0, sizeof(fgVectorElement));
     self->isordered = 1;
     self->fixedsize.x = -1;
     self->fixedsize.y = -1;
+    self->batch = 0;
+    self->removing = 0;
     break;
   case FG_SETFLAG: // Do the same thing fgElement does to resolve a SETFLAG into SETFLAGS
     otherint = T_SETBIT(flags, otherint, msg->u2);
@@ -163,18 +343,58 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
     if(element->flags&(FGBOX_DISTRIBUTEX | FGBOX_DISTRIBUTEY))
       return fgDistributeLayout(element, (const FG_Msg*)msg->p, element->flags&FGBOX_LAYOUTMASK, (AbsVec*)msg->p2);
     break; // If no layout flags are specified, fall back to default layout behavior.
+  case FG_LAYOUTCHANGE:
+    if(msg->subtype == FGELEMENT_LAYOUTREORDER) // The child list was rearranged, so the array has to be updated before the layout looks at it
+    {
+      if(!self->isordered || !msg->e) // If we weren't ordered, the reorder might have fixed it
+        fgBoxOrderedElement_Rebuild(self, element);
+      else if(msg->e2 == msg->e) // A block of children was moved, and msg->e is the first position that changed
+        fgBoxOrderedElement_RebuildFrom(self, element, msg->e);
+      else
+        fgBoxOrderedElement_Move(self, element, msg->e);
+    }
+    if(self->batch > 0) // The whole layout is reset once the batch ends
+      return FG_ACCEPT;
+    break;
   case FG_REMOVECHILD:
   {
-    for(size_t i = 0; i < self->ordered.l; ++i)
-      if(self->ordered.p[i] == msg->e)
-        ((bss_util::cDynArray<fgElement*>&)self->ordered).Remove(i);
+    for(size_t i = self->deferred.l; i-- > 0;) // Children removed before the batch ends no longer need their skin applied
+      if(self->deferred.p[i] == msg->e)
+      {
+        self->deferred.p[i] = self->deferred.p[--self->deferred.l];
+        break;
+      }
+    if(self->isordered && msg->e != 0 && msg->e->parent == element && !(msg->e->flags&FGELEMENT_BACKGROUND))
+    {
+      size_t i = msg->e->orderindex;
+      if(i < self->ordered.l && self->ordered.p[i] == msg->e)
+      {
+        if(self->removing && i + 1 < self->ordered.l) // Leave a hole, which gets compacted once the bulk removal is done
+          self->ordered.p[i] = 0;
+        else
+        {
+          ((bss_util::cDynArray<fgElement*>&)self->ordered).Remove(i);
+          fgBoxOrderedElement_Reindex(self, i, self->ordered.l);
+        }
+      }
+    }
 
     size_t r = callback(element, msg);
-    self->isordered = checkIsOrdered(element->root);
+    if(!self->isordered && !self->removing) // Removing an element can't break the ordering, so we only have to check if it was broken before
+      fgBoxOrderedElement_Rebuild(self, element);
     return r;
   }
   case FG_ADDCHILD:
     assert(msg->p != 0);
+    if(self->batch > 0 && !msg->e->parent && msg->subtype != FGADDCHILD_DEFER) // The skin and position of every child added during a batch are applied once it ends
+    {
+      FG_Msg m = *msg;
+      m.subtype = FGADDCHILD_DEFER;
+      if(fgBoxOrderedElement_Message(self, &m, element, callback) != FG_ACCEPT)
+        return 0;
+      ((bss_util::cDynArray<fgElement*>&)self->deferred).Add(msg->e);
+      return FG_ACCEPT;
+    }
     if(callback(element, msg) == FG_ACCEPT)
     {
       fgElement* next = msg->e->next;
@@ -202,13 +422,16 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
         if(self->isordered) // if we're still ordered then we add this to our vector
         {
           if(!next || next->flags&FGELEMENT_BACKGROUND)
+          {
+            msg->e->orderindex = self->ordered.l;
             ((bss_util::cDynArray<fgElement*>&)self->ordered).Add(msg->e);
+          }
           else
           {
-            size_t i = self->ordered.l;
-            while(i > 0 && self->ordered.p[--i] != next);
-            assert(!self->ordered.p || self->ordered.p[i] == next);
+            size_t i = next->orderindex; // The element we're inserting before already knows where it is
+            assert(i < self->ordered.l && self->ordered.p[i] == next);
             ((bss_util::cDynArray<fgElement*>&)self->ordered).Insert(msg->e, i);
+            fgBoxOrderedElement_Reindex(self, i, self->ordered.l);
           }
         }
         else
@@ -218,6 +441,15 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
     }
     return 0;
   case FG_ADDITEM:
+    if(msg->subtype == FGITEM_ELEMENTARRAY)
+    {
+      fgElement** items = (fgElement**)msg->p;
+      fgBoxOrderedElement_BeginBatch(self, msg->u2);
+      for(size_t i = 0; i < msg->u2; ++i)
+        element->AddChild(items[i], 0);
+      fgBoxOrderedElement_EndBatch(self, element);
+      return msg->u2;
+    }
     if(!self->isordered || msg->subtype != FGITEM_ELEMENT)
       return 0; // Can't set anything if we aren't ordered
     else
@@ -227,6 +459,8 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
       return FG_ACCEPT;
     }
   case FG_REMOVEITEM:
+    if(msg->subtype == FGITEM_ELEMENTARRAY)
+      return fgBoxOrderedElement_RemoveItems(self, element, (fgElement**)msg->p, msg->u2);
     if(!self->isordered)
       return 0; // Can't remove by index if we aren't ordered
     if(msg->u < self->ordered.l)
@@ -254,6 +488,20 @@ size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const
     else if(size_t(msg->i) < self->ordered.l)
       return (size_t)self->ordered.p[msg->i];
     return 0;
+  case FG_SETDIM:
+    if(msg->subtype != FGDIM_FIXED)
+      break;
+    if(self->fixedsize.x != msg->f || self->fixedsize.y != msg->f2)
+    {
+      self->fixedsize.x = msg->f;
+      self->fixedsize.y = msg->f2;
+      fgSubMessage(element, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+    }
+    return FG_ACCEPT;
+  case FG_GETDIM:
+    if(msg->subtype == FGDIM_FIXED)
+      return (size_t)&self->fixedsize;
+    break;
   case FG_SETITEM:
     if(!self->isordered || msg->subtype != FGITEM_ELEMENT)
       return 0; // Can't set anything if we aren't ordered
@@ -99,6 +99,8 @@ size_t fgCurve_Message(fgCurve* self, const FG_Msg* msg)
       return (size_t)self->factor;
     return 0;
   case FG_ADDITEM:
+    if(msg->subtype == FGITEM_TEXTARRAY || msg->subtype == FGITEM_ELEMENTARRAY) // A curve only holds points
+      return 0;
     if(msg->u2 >= self->points.l)
       reinterpret_cast<cDynArray<AbsVec>&>(self->points).Add(*(AbsVec*)msg->p);
     else
@@ -112,6 +114,8 @@ size_t fgCurve_Message(fgCurve* self, const FG_Msg* msg)
       return 0;
     return (size_t)(self->points.p + msg->u);
   case FG_REMOVEITEM:
+    if(msg->subtype == FGITEM_ELEMENTARRAY || msg->u >= self->points.l)
+      return 0;
     reinterpret_cast<cDynArray<AbsVec>&>(self->points).Remove(msg->u);
     self->cache.l = 0;
     break;
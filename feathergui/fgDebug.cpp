@@ -5,6 +5,8 @@
 #include "fgRoot.h"
 #include "feathercpp.h"
 #include "bss-util/cDynArray.h"
+#include <atomic>
+#include <chrono>
 
 fgDebug* fgdebug_instance = nullptr;
 
@@ -99,8 +101,15 @@ size_t fgDebug_Message(fgDebug* self, const FG_Msg* msg)
     fgGrid_Init(&self->properties, *self, 0, "Debug$properties", FGELEMENT_HIDDEN, &tf_properties, 0);
     fgTreeview_Init(&self->messages, *self, 0, "Debug$messages", 0, &tf_messages, 0);
     fgText_Init(&self->contents, *self, 0, "Debug$contents", FGELEMENT_HIDDEN, &tf_contents, 0);
+    fgGrid_Init(&self->profile, *self, 0, "Debug$profile", FGELEMENT_HIDDEN, &tf_properties, 0);
     self->properties.InsertColumn("Name");
     self->properties.InsertColumn("Value");
+    self->profile.InsertColumn("Class");
+    self->profile.InsertColumn("Message");
+    self->profile.InsertColumn("Count");
+    self->profile.InsertColumn("Inclusive (ms)");
+    self->profile.InsertColumn("Exclusive (ms)");
+    self->profile.InsertColumn("Median (us)");
     for(size_t i = 0; i < sizeof(PROPERTY_LIST) / sizeof(const char*); ++i)
     {
       fgGridRow* r = self->properties.InsertRow();
@@ -899,3 +908,219 @@ void fgDebug_DumpMessages(fgDebug* self, const char* file)
     fgDebug_WriteMessageFn<FILE*>(self->messagelog.p + i, &fprintf, f);
   fclose(f);
 }
+
+static struct
+{
+  fgTraceRecord* buffer;
+  size_t mask;
+  std::atomic<unsigned long long> next; // Total number of records ever reserved. Writers claim a slot by incrementing this, so no lock is needed.
+  unsigned int depth;
+  std::chrono::steady_clock::time_point start;
+  size_t(*behaviorhook)(struct _FG_ELEMENT* self, const FG_Msg* msg);
+} fgTrace;
+
+void fgTrace_Start(fgTraceRecord* buffer, size_t capacity)
+{
+  assert(buffer != 0 && capacity != 0 && !(capacity & (capacity - 1)));
+  if(fgroot_instance->backend.behaviorhook == &fgRoot_BehaviorTrace)
+    return;
+  fgTrace.buffer = buffer;
+  fgTrace.mask = capacity - 1;
+  fgTrace.next = 0;
+  fgTrace.depth = 0;
+  fgTrace.start = std::chrono::steady_clock::now();
+  fgTrace.behaviorhook = fgroot_instance->backend.behaviorhook;
+  fgroot_instance->backend.behaviorhook = &fgRoot_BehaviorTrace;
+}
+
+void fgTrace_Stop()
+{
+  if(fgroot_instance->backend.behaviorhook == &fgRoot_BehaviorTrace)
+    fgroot_instance->backend.behaviorhook = fgTrace.behaviorhook;
+}
+
+size_t fgTrace_Dump(const char* file)
+{
+  if(!fgTrace.buffer)
+    return 0;
+  FILE* f;
+  FOPEN(f, file, "wb");
+  if(!f)
+    return 0;
+
+  unsigned long long total = fgTrace.next.load(std::memory_order_acquire);
+  unsigned int size = sizeof(fgTraceRecord);
+  size_t count = (total > fgTrace.mask) ? (fgTrace.mask + 1) : (size_t)total;
+  size_t first = (size_t)(total - count) & fgTrace.mask;
+  fwrite("FGTR", 1, 4, f);
+  fwrite(&size, sizeof(size), 1, f);
+  fwrite(&total, sizeof(total), 1, f);
+  fwrite(fgTrace.buffer + first, sizeof(fgTraceRecord), fgTrace.mask + 1 - first < count ? fgTrace.mask + 1 - first : count, f);
+  if(first + count > fgTrace.mask + 1) // The oldest records are at the end of the buffer, so write the part that wrapped around second
+    fwrite(fgTrace.buffer, sizeof(fgTraceRecord), first + count - (fgTrace.mask + 1), f);
+  fclose(f);
+  return count;
+}
+
+size_t fgRoot_BehaviorTrace(fgElement* self, const FG_Msg* msg)
+{
+  unsigned long long index = fgTrace.next.fetch_add(1, std::memory_order_relaxed);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  fgTraceRecord* record = fgTrace.buffer + (index & fgTrace.mask);
+  record->time = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(begin - fgTrace.start).count();
+  record->element = (unsigned long long)(size_t)self;
+  record->type = msg->type;
+  record->subtype = msg->subtype;
+  record->depth = fgTrace.depth;
+  record->duration = 0;
+  record->result = 0;
+
+  ++fgTrace.depth;
+  size_t r = (*fgTrace.behaviorhook)(self, msg);
+  --fgTrace.depth;
+
+  if(fgTrace.next.load(std::memory_order_relaxed) - index <= fgTrace.mask + 1) // If the nested messages lapped the buffer, this slot now belongs to someone else
+  {
+    unsigned long long duration = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    record->duration = (duration > 0xFFFFFFFFULL) ? 0xFFFFFFFF : (unsigned int)duration;
+    record->result = (unsigned int)r;
+  }
+  return r;
+}
+
+struct fgProfileClass
+{
+  const char* name;
+  fgProfileStat stats[FG_CUSTOMEVENT + 1];
+};
+
+static struct fgProfileState
+{
+  ~fgProfileState() { for(khiter_t i : classes) free(classes.UnsafeValue(i)); } // Allocated with calloc because this can outlive the leak tracker
+  bss_util::cHashBase<void*, fgProfileClass*, true, bss_util::KH_POINTER_HASHFUNC<void* const&>, bss_util::KH_INT_EQUALFUNC<void*>> classes; // Keyed on the message function
+  unsigned long long children[FGPROFILE_MAXDEPTH]; // Time spent in messages sent by the message currently being handled at each depth
+  unsigned int depth;
+  double interval;
+  fgDeferAction* reset;
+  size_t(*behaviorhook)(struct _FG_ELEMENT* self, const FG_Msg* msg);
+} fgProfile;
+
+static char fgProfile_Interval(void*)
+{
+  fgProfile_Reset();
+  fgProfile.reset->time = fgroot_instance->time + fgProfile.interval;
+  fgRoot_AddAction(fgroot_instance, fgProfile.reset);
+  return 0; // We own the action, so it shouldn't be deallocated
+}
+
+void fgProfile_Start(double interval)
+{
+  if(fgroot_instance->backend.behaviorhook == &fgRoot_BehaviorProfile)
+    return;
+  fgProfile_Reset();
+  fgProfile.depth = 0;
+  fgProfile.interval = interval;
+  if(interval > 0.0)
+  {
+    fgProfile.reset = fgRoot_AllocAction(&fgProfile_Interval, 0, fgroot_instance->time + interval);
+    fgRoot_AddAction(fgroot_instance, fgProfile.reset);
+  }
+  fgProfile.behaviorhook = fgroot_instance->backend.behaviorhook;
+  fgroot_instance->backend.behaviorhook = &fgRoot_BehaviorProfile;
+}
+
+void fgProfile_Stop()
+{
+  if(fgroot_instance->backend.behaviorhook == &fgRoot_BehaviorProfile)
+    fgroot_instance->backend.behaviorhook = fgProfile.behaviorhook;
+  if(fgProfile.reset)
+    fgRoot_DeallocAction(fgroot_instance, fgProfile.reset);
+  fgProfile.reset = 0;
+}
+
+void fgProfile_Reset()
+{
+  for(khiter_t i : fgProfile.classes)
+    memset(fgProfile.classes.UnsafeValue(i)->stats, 0, sizeof(fgProfileClass::stats));
+}
+
+void fgProfile_Iterate(void* p, void(*fn)(void*, const char* classname, unsigned short type, const fgProfileStat* stat))
+{
+  for(khiter_t i : fgProfile.classes)
+  {
+    fgProfileClass* c = fgProfile.classes.UnsafeValue(i);
+    for(unsigned short type = 0; type <= FG_CUSTOMEVENT; ++type)
+      if(c->stats[type].count > 0)
+        fn(p, c->name, type, c->stats + type);
+  }
+}
+
+size_t fgRoot_BehaviorProfile(fgElement* self, const FG_Msg* msg)
+{
+  khiter_t iter = fgProfile.classes.Iterator((void*)self->message);
+  fgProfileClass* c;
+  if(fgProfile.classes.ExistsIter(iter))
+    c = fgProfile.classes.UnsafeValue(iter);
+  else
+  {
+    c = (fgProfileClass*)calloc(1, sizeof(fgProfileClass));
+    FG_Msg m = { 0 };
+    m.type = FG_GETCLASSNAME;
+    c->name = (const char*)(*fgProfile.behaviorhook)(self, &m); // Asked before timing starts, so it isn't counted
+    fgProfile.classes.Insert((void*)self->message, c);
+  }
+  fgProfileStat& stat = c->stats[msg->type < FG_CUSTOMEVENT ? msg->type : FG_CUSTOMEVENT];
+
+  unsigned int depth = fgProfile.depth++;
+  if(depth < FGPROFILE_MAXDEPTH)
+    fgProfile.children[depth] = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  size_t r = (*fgProfile.behaviorhook)(self, msg);
+  unsigned long long inclusive = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+  fgProfile.depth = depth;
+
+  unsigned long long children = (depth < FGPROFILE_MAXDEPTH) ? fgProfile.children[depth] : 0;
+  if(depth > 0 && depth <= FGPROFILE_MAXDEPTH)
+    fgProfile.children[depth - 1] += inclusive;
+  stat.count += 1;
+  stat.inclusive += inclusive;
+  stat.exclusive += (children < inclusive) ? inclusive - children : 0;
+  stat.histogram[bss_util::bsslog2((uint32_t)(inclusive > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : inclusive))] += 1;
+  return r;
+}
+
+struct fgProfileRow
+{
+  const char* name;
+  unsigned short type;
+  const fgProfileStat* stat;
+};
+
+void fgDebug_ShowProfile(fgDebug* self)
+{
+  bss_util::cDynArray<fgProfileRow> rows;
+  fgProfile_Iterate(&rows, [](void* p, const char* name, unsigned short type, const fgProfileStat* stat) { ((bss_util::cDynArray<fgProfileRow>*)p)->Add(fgProfileRow { name, type, stat }); });
+  std::sort(rows.begin(), rows.end(), [](const fgProfileRow& l, const fgProfileRow& r) { return l.stat->exclusive > r.stat->exclusive; });
+
+  while(self->profile.RemoveRow(0));
+  char buf[32];
+  for(const fgProfileRow& row : rows)
+  {
+    fgGridRow* r = self->profile.InsertRow();
+    r->InsertItem(row.name ? row.name : "");
+    r->InsertItem(row.type < FG_CUSTOMEVENT ? fgDebug_GetMessageString(row.type) : "FG_CUSTOMEVENT");
+    snprintf(buf, sizeof(buf), "%llu", row.stat->count);
+    r->InsertItem(buf);
+    snprintf(buf, sizeof(buf), "%.3f", row.stat->inclusive / 1000000.0);
+    r->InsertItem(buf);
+    snprintf(buf, sizeof(buf), "%.3f", row.stat->exclusive / 1000000.0);
+    r->InsertItem(buf);
+
+    unsigned long long half = (row.stat->count + 1) / 2;
+    size_t bucket = 0;
+    for(unsigned long long seen = 0; bucket < FGPROFILE_BUCKETS - 1 && (seen += row.stat->histogram[bucket]) < half; ++bucket);
+    snprintf(buf, sizeof(buf), "< %.3g", (2ULL << bucket) / 1000.0); // The median is somewhere in this bucket, so show its upper bound
+    r->InsertItem(buf);
+  }
+  self->profile->SetFlag(FGELEMENT_HIDDEN, false);
+}
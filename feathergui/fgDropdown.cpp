@@ -12,6 +12,7 @@ void fgDropdown_Init(fgDropdown* BSS_RESTRICT self, fgElement* BSS_RESTRICT pare
 
 void fgDropdown_Destroy(fgDropdown* self)
 {
+  fgTypeahead_Destroy(&self->typeahead);
   fgBox_Destroy(&self->box);
   self->control->message = (fgMessage)fgControl_Message;
   fgControl_Destroy(&self->control);
@@ -84,6 +85,20 @@ size_t fgDropdownBox_Message(fgBox* self, const FG_Msg* msg)
     if(!parent->dropflag)
       parent->dropflag = 1;
     break;
+  case FG_REMOVECHILD: // The items are our children, so this catches them being freed directly as well as through the dropdown
+    if(msg->e == parent->selected)
+      parent->selected = 0;
+    if(msg->e->parent == *self)
+      fgTypeahead_Remove(&parent->typeahead, msg->e);
+    break;
+  case FG_ADDCHILD:
+    if(!msg->e->parent)
+      fgTypeahead_Add(&parent->typeahead, msg->e);
+    break;
+  case FG_LAYOUTCHANGE:
+    if(msg->subtype == FGELEMENT_LAYOUTREORDER)
+      parent->typeahead.dirty = 1;
+    break;
   }
   return fgBox_Message(self, msg);
 }
@@ -101,6 +116,7 @@ size_t fgDropdown_Message(fgDropdown* self, const FG_Msg* msg)
     self->selected = 0;
     self->dropflag = 0;
     self->hover.color = 0x99999999;
+    fgTypeahead_Init(&self->typeahead);
     break;
   }
   case FG_MOUSEDOWN:
@@ -132,6 +148,24 @@ size_t fgDropdown_Message(fgDropdown* self, const FG_Msg* msg)
     if(msg->e->flags & FGELEMENT_BACKGROUND)
       break;
     return (*self->box->message)(self->box, msg);
+  case FG_KEYCHAR: // Select the first item whose text starts with what the user typed
+  {
+    fgElement* item = fgTypeahead_Search(&self->typeahead, &self->box, msg->keychar);
+    if(!item)
+      break;
+    if(self->selected)
+      fgStandardNeutralSetStyle(self->selected, "selected", FGSETSTYLE_REMOVEFLAG);
+    self->selected = item;
+    fgStandardNeutralSetStyle(item, "selected", FGSETSTYLE_SETFLAG);
+    if(!(self->box->flags&FGELEMENT_HIDDEN))
+    {
+      AbsRect r;
+      ResolveRect(item, &r);
+      _sendsubmsg<FG_ACTION, void*>(self->box, FGSCROLLBAR_SCROLLTOABS, &r);
+    }
+    fgroot_instance->backend.fgDirtyElement(*self);
+    return FG_ACCEPT;
+  }
   case FG_GETCOLOR:
     switch(msg->subtype)
     {
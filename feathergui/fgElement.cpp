@@ -12,11 +12,6 @@
 
 KHASH_INIT(fgUserdata, const char*, size_t, 1, kh_str_hash_func, kh_str_hash_equal);
 
-template<typename U, typename V>
-BSS_FORCEINLINE char CompPairInOrder(const std::pair<U, V>& l, const std::pair<U, V>& r) { char ret = SGNCOMPARE(l.first, r.first); return !ret ? SGNCOMPARE(l.second, r.second) : ret; }
-
-bss_util::cAVLtree<std::pair<fgElement*, unsigned short>, void, &CompPairInOrder> fgListenerList;
-
 struct fgStoredMessage
 {
   explicit fgStoredMessage(fgElement* t) : target(t), msg(0) {}
@@ -144,6 +139,7 @@ void fgElement_Destroy(fgElement* self)
     fgfree(self->layoutstyle, __FILE__, __LINE__);
   }
   fgElement_ClearListeners(self);
+  fgAnimation_Stop(self, (unsigned short)-1);
   assert(fgFocusedWindow != self); // If these assertions fail something is wrong with how the message chain is constructed
   assert(fgLastHover != self);
   assert(fgCaptureWindow != self);
@@ -575,7 +571,8 @@ size_t fgElement_Message(fgElement* self, const FG_Msg* msg)
     assert(!msg->e->parent);
     assert(msg->p2 != self);
     msg->e->parent = self;
-    _sendmsg<FG_SETSKIN>(msg->e);
+    if(msg->subtype != FGADDCHILD_DEFER)
+      _sendmsg<FG_SETSKIN>(msg->e);
     LList_InsertAll(msg->e, (fgElement*)msg->p2);
     if(!(msg->e->flags&FGELEMENT_BACKGROUND))
       _sendsubmsg<FG_LAYOUTCHANGE, void*, size_t>(self, FGELEMENT_LAYOUTADD, msg->e, 0);
@@ -583,7 +580,8 @@ size_t fgElement_Message(fgElement* self, const FG_Msg* msg)
     assert(!msg->e->last || !msg->e->last->next);
     assert(!msg->e->lastinject || !msg->e->lastinject->nextinject);
     assert(!msg->e->lastnoclip || !msg->e->lastnoclip->nextnoclip);
-    _sendsubmsg<FG_MOVE, void*, size_t>(msg->e, FG_SETPARENT, 0, fgElement_PotentialResize(self));
+    if(msg->subtype != FGADDCHILD_DEFER)
+      _sendsubmsg<FG_MOVE, void*, size_t>(msg->e, FG_SETPARENT, 0, fgElement_PotentialResize(self));
     _sendmsg<FG_PARENTCHANGE, void*, void*>(msg->e, msg->e->parent, 0);
     return FG_ACCEPT;
   case FG_REMOVECHILD:
@@ -1173,10 +1171,103 @@ FG_EXTERN void* fgGetPtrMessage(fgElement* self, unsigned short type, unsigned s
 
 void fgElement_Clear(fgElement* self)
 {
-  while(self->root) // Destroy all children
+  size_t n = 0;
+  for(fgElement* cur = self->root; cur != 0; cur = cur->next)
+    ++n;
+  if(n > 1) // Containers that keep their children in an array can remove them all in one pass
+  {
+    bss_util::cDynArray<fgElement*> children(n);
+    for(fgElement* cur = self->root; cur != 0; cur = cur->next)
+      children.Add(cur);
+    _sendsubmsg<FG_REMOVEITEM, const void*, size_t>(self, FGITEM_ELEMENTARRAY, children.begin(), n);
+  }
+  while(self->root) // Destroy whatever is left
     VirtualFreeChild(self->root);
 }
 
+size_t fgElement_AddItems(fgElement* self, const char** items, size_t n)
+{
+  size_t r = _sendsubmsg<FG_ADDITEM, const void*, size_t>(self, FGITEM_TEXTARRAY, items, n);
+  if(r != 0 || !n)
+    return r;
+  for(size_t i = 0; i < n; ++i) // If bulk insertion isn't supported, fall back to adding each item individually
+    r += self->AddItemText(items[i]) != 0;
+  return r;
+}
+
+size_t fgElement_AddItemElements(fgElement* self, fgElement** items, size_t n)
+{
+  size_t r = _sendsubmsg<FG_ADDITEM, const void*, size_t>(self, FGITEM_ELEMENTARRAY, items, n);
+  if(r != 0 || !n)
+    return r;
+  for(size_t i = 0; i < n; ++i)
+    r += self->AddItemElement(items[i]) != 0;
+  return r;
+}
+
+size_t fgElement_RemoveItemElements(fgElement* self, fgElement** items, size_t n)
+{
+  size_t r = _sendsubmsg<FG_REMOVEITEM, const void*, size_t>(self, FGITEM_ELEMENTARRAY, items, n);
+  if(r != 0 || !n)
+    return r;
+  for(size_t i = 0; i < n; ++i) // If bulk removal isn't supported, free each child individually
+    if(items[i] != 0 && items[i]->parent == self)
+    {
+      VirtualFreeChild(items[i]);
+      ++r;
+    }
+  return r;
+}
+
+void fgElement_ReorderChildren(fgElement* self, fgElement* const* children, size_t n, fgElement* next)
+{
+  if(!n)
+    return;
+  if(n == 1) // A single move is reported the same way SETPARENT reports it
+  {
+    if(children[0]->next != next)
+    {
+      fgElement* old = children[0]->next;
+      LList_RemoveAll(children[0]);
+      LList_InsertAll(children[0], next);
+      fgroot_instance->backend.fgDirtyElement(self);
+      _sendsubmsg<FG_LAYOUTCHANGE, void*, fgElement*>(self, FGELEMENT_LAYOUTREORDER, children[0], old);
+    }
+    return;
+  }
+
+  // Find the first moved child in the old order, along with the first child after it that doesn't move. This can be every row of a large grid, so the
+  // sorted copy goes on the heap instead of the stack.
+  bss_util::cDynArray<fgElement*> moved(n);
+  moved.SetLength(n);
+  MEMCPY(moved.begin(), n * sizeof(fgElement*), children, n * sizeof(fgElement*));
+  std::sort(moved.begin(), moved.end());
+  fgElement* first = self->root;
+  while(first != 0 && !std::binary_search(moved.begin(), moved.end(), first)) first = first->next;
+  fgElement* after = first;
+  while(after != 0 && std::binary_search(moved.begin(), moved.end(), after)) after = after->next;
+
+  for(size_t i = 0; i < n; ++i) // Relinking in place means no ADDCHILD or REMOVECHILD, so the parent only has to react to the final reorder message.
+  {
+    assert(children[i]->parent == self && children[i] != next && !(children[i]->flags&FGELEMENT_BACKGROUND));
+    LList_RemoveAll(children[i]);
+    LList_InsertAll(children[i], next);
+  }
+
+  // Everything before the old position of the first moved child is untouched, so the first changed position is either that old position, now held
+  // by after, or wherever the block was inserted, whichever comes first.
+  fgElement* start = children[0];
+  if(after != 0 && !(after->flags&FGELEMENT_BACKGROUND))
+  {
+    fgElement* cur = after;
+    while(cur != 0 && cur != children[0]) cur = cur->next;
+    if(cur != 0)
+      start = after;
+  }
+  fgroot_instance->backend.fgDirtyElement(self);
+  _sendsubmsg<FG_LAYOUTCHANGE, void*, fgElement*>(self, FGELEMENT_LAYOUTREORDER, start, start);
+}
+
 fgElement* fgElement_GetChildUnderMouse(fgElement* self, float x, float y, AbsRect* cache)
 {
   ResolveRect(self, cache);
@@ -1220,33 +1311,16 @@ void fgElement_MouseMoveCheck(fgElement* self)
 
 void fgElement_AddListener(fgElement* self, unsigned short type, fgListener listener)
 {
-  fgListenerList.Insert(std::pair<fgElement*, unsigned short>(self, type));
-  fgListenerHash.Insert(std::pair<fgElement*, unsigned short>(self, type), listener);
+  fgListenerHash.Insert(self, type, listener);
+  self->listeners |= fgListenerBit(type);
 }
 
-bss_util::AVL_Node<std::pair<fgElement*, unsigned short>>* fgElement_GetAnyListener(fgElement* key, bss_util::AVL_Node<std::pair<fgElement*, unsigned short>>* cur)
-{
-  while(cur)
-  {
-    switch(SGNCOMPARE(cur->_key.first, key)) // by only comparing the first half of the key, we can find all the nodes for a given fgElement*
-    {
-    case -1: cur = cur->_left; break;
-    case 1: cur = cur->_right; break;
-    default: return cur;
-    }
-  }
-
-  return 0;
-}
 void fgElement_ClearListeners(fgElement* self)
 {
-  bss_util::AVL_Node<std::pair<fgElement*, unsigned short>>* cur;
-
-  while(cur = fgElement_GetAnyListener(self, fgListenerList.GetRoot()))
-  {
-    fgListenerHash.Remove(cur->_key);
-    fgListenerList.Remove(cur->_key);
-  }
+  if(!self->listeners) // Every element calls this when it's destroyed, so skip the table entirely if it never had a listener
+    return;
+  fgListenerHash.RemoveAll(self, self->listeners);
+  self->listeners = 0;
 } 
 
 void fgElement::Construct() { _sendmsg<FG_CONSTRUCT>(this); }
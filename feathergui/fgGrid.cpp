@@ -4,6 +4,10 @@
 #include "fgGrid.h"
 #include "feathercpp.h"
 #include "bss-util/cDynArray.h"
+#include <algorithm>
+#include <stdlib.h>
+
+static const char* FGSTR_GRID = "Grid";
 
 size_t fgPlaceholder_Message(fgElement* self, const FG_Msg* msg) { return fgElement_Message(self, msg); }
 
@@ -25,9 +29,276 @@ void fgGrid_Init(fgGrid* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgEl
 }
 void fgGrid_Destroy(fgGrid* self)
 {
+  ((bss_util::cDynArray<fgGridTrack>&)self->tracks).~cDynArray();
   self->list->message = (fgMessage)fgList_Message;
   fgList_Destroy(&self->list);
 }
+inline void fgGrid_PlaceCell(fgGrid* self, fgElement* cell, size_t column)
+{
+  const fgGridTrack& t = self->tracks.p[column];
+  cell->SetArea(CRect { t.offset, 0, 0, 0, t.offset + t.width, 0, 0, 1 });
+}
+
+// Redoes the layout of every visible row that was placed with older tracks. Rows outside the view stay stale until they scroll into it.
+void fgGrid_SyncRows(fgGrid* self)
+{
+  if(self->source.rows != 0)
+    return;
+  fgElement** rows = self->list.box.order.ordered.p;
+  size_t n = self->list.box.order.ordered.l;
+  size_t i = 0;
+  AbsRect area;
+  ResolveRect(*self, &area);
+  if(self->list.box.order.isordered && n > 0)
+    i = fgBoxOrderedElement_GetVisible(&self->list.box.order, self->list->flags, &area, &area);
+  for(; i < n; ++i)
+  {
+    AbsRect r;
+    ResolveRectCache(rows[i], &r, &area, &self->list->padding);
+    if(r.top > area.bottom)
+      break;
+    if(((fgGridRow*)rows[i])->trackversion != self->trackversion)
+      fgSubMessage(rows[i], FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+  }
+}
+
+// Moves the cells of every visible row to the new tracks. Virtual rows place their cells explicitly, other rows redo their layout.
+void fgGrid_ApplyTracks(fgGrid* self)
+{
+  ++self->trackversion;
+  if(self->source.rows != 0)
+  {
+    for(size_t i = 0; i < self->list.pool.l; ++i)
+    {
+      fgGridRow* row = (fgGridRow*)self->list.pool.p[i];
+      for(size_t j = 0; j < row->cells.l && row->cellstart + j < self->tracks.l; ++j)
+        fgGrid_PlaceCell(self, row->cells.p[j], row->cellstart + j);
+      row->trackversion = self->trackversion;
+    }
+  }
+  else
+    fgGrid_SyncRows(self);
+}
+
+void fgGrid_UpdateTracks(fgGrid* self)
+{
+  bss_util::cDynArray<fgGridTrack>& tracks = (bss_util::cDynArray<fgGridTrack>&)self->tracks;
+  tracks.SetLength(self->header.box.order.ordered.l);
+  FABS offset = 0;
+  for(size_t i = 0; i < tracks.Length(); ++i)
+  {
+    tracks[i].offset = offset;
+    tracks[i].width = fgLayout_GetElementWidth(self->header.box.order.ordered.p[i]);
+    offset += tracks[i].width;
+  }
+  fgGrid_ApplyTracks(self);
+}
+
+// Updates a single column's width and the offsets of every column after it. Returns false if nothing changed.
+bool fgGrid_UpdateTrack(fgGrid* self, size_t column)
+{
+  FABS width = fgLayout_GetElementWidth(self->header.box.order.ordered.p[column]);
+  if(self->tracks.p[column].width == width)
+    return false;
+  self->tracks.p[column].width = width;
+  for(size_t i = column + 1; i < self->tracks.l; ++i)
+    self->tracks.p[i].offset = self->tracks.p[i - 1].offset + self->tracks.p[i - 1].width;
+  fgGrid_ApplyTracks(self);
+  return true;
+}
+
+inline FABS fgGrid_TotalWidth(fgGrid* self) { return !self->tracks.l ? 0 : self->tracks.p[self->tracks.l - 1].offset + self->tracks.p[self->tracks.l - 1].width; }
+
+// Returns the first column whose right edge is past x
+inline size_t fgGrid_FindColumn(fgGrid* self, FABS x)
+{
+  size_t lo = 0;
+  size_t hi = self->tracks.l;
+  while(lo < hi)
+  {
+    size_t mid = lo + ((hi - lo) >> 1);
+    if(self->tracks.p[mid].offset + self->tracks.p[mid].width <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Makes sure a virtual row has a cell for exactly the columns in [colstart, colend), recycling cells that scrolled out of view.
+void fgGrid_RealizeCells(fgGrid* self, fgGridRow* row, bool rebind)
+{
+  bss_util::cDynArray<fgElement*>& cells = (bss_util::cDynArray<fgElement*>&)row->cells;
+  if(!rebind && row->cellstart == self->colstart && row->cellstart + cells.Length() == self->colend)
+    return;
+
+  bss_util::cDynArray<fgElement*> next(self->colend - self->colstart);
+  bss_util::cDynArray<fgElement*> recycle;
+  next.SetLength(self->colend - self->colstart);
+  for(size_t i = 0; i < next.Length(); ++i)
+    next[i] = 0;
+  for(size_t i = 0; i < cells.Length(); ++i)
+  {
+    size_t column = row->cellstart + i;
+    if(!rebind && column >= self->colstart && column < self->colend)
+      next[column - self->colstart] = cells[i];
+    else
+      recycle.Add(cells[i]);
+  }
+  for(size_t i = 0; i < next.Length(); ++i)
+  {
+    if(!next[i])
+    {
+      if(recycle.Length() > 0)
+      {
+        next[i] = recycle.Back();
+        recycle.RemoveLast();
+      }
+      else
+        next[i] = fgroot_instance->backend.fgCreate(!self->source.type ? "Text" : self->source.type, *row, 0, "Grid$cell", 0, &fgTransform_EMPTY, 0);
+      self->source.bind(self->source.user, next[i], self->colstart + i, row->index);
+      fgGrid_PlaceCell(self, next[i], self->colstart + i);
+    }
+  }
+  for(size_t i = 0; i < recycle.Length(); ++i)
+    VirtualFreeChild(recycle[i]);
+  cells = std::move(next);
+  row->cellstart = self->colstart;
+}
+
+// Recalculates which columns are visible, and updates the cells of every visible row if that changed.
+void fgGrid_RealizeColumns(fgGrid* self, bool force)
+{
+  static const size_t OVERSCAN = 1;
+  AbsRect r;
+  ResolveRect(*self, &r);
+  FABS offset = self->list.box.scroll.realpadding.left - self->list->padding.left;
+  size_t start = fgGrid_FindColumn(self, offset);
+  size_t end = bssmin(fgGrid_FindColumn(self, offset + r.right - r.left) + 1, self->tracks.l);
+  start = (start > OVERSCAN) ? start - OVERSCAN : 0;
+  end = bssmin(end + OVERSCAN, self->tracks.l);
+  if(start > end)
+    start = end;
+  if(!force && start == self->colstart && end == self->colend)
+    return;
+  self->colstart = start;
+  self->colend = end;
+  for(size_t i = 0; i < self->list.pool.l; ++i)
+    fgGrid_RealizeCells(self, (fgGridRow*)self->list.pool.p[i], false);
+}
+
+size_t fgGrid_CountRows(void* user)
+{
+  fgGrid* self = (fgGrid*)user;
+  return self->source.rows(self->source.user);
+}
+
+void fgGrid_BindRow(void* user, fgElement* item, size_t index)
+{
+  fgGrid* self = (fgGrid*)user;
+  fgGridRow* row = (fgGridRow*)item;
+  row->index = index;
+  fgGrid_RealizeCells(self, row, true);
+}
+
+void fgGrid_SetSource(fgGrid* self, const fgGridSource* source)
+{
+  if(source != 0)
+    self->source = *source;
+  else
+    memset(&self->source, 0, sizeof(fgGridSource));
+  fgGrid_UpdateTracks(self);
+  self->colstart = 0;
+  self->colend = 0;
+  fgGrid_RealizeColumns(self, true);
+  if(!self->source.rows)
+    return fgList_SetSource(&self->list, 0);
+  fgListSource rows = { &fgGrid_CountRows, &fgGrid_BindRow, self, "GridRow" };
+  fgList_SetSource(&self->list, &rows);
+}
+
+void fgGrid_Refresh(fgGrid* self)
+{
+  fgGrid_UpdateTracks(self);
+  fgGrid_RealizeColumns(self, false);
+  fgList_Refresh(&self->list);
+}
+
+struct fgGridSortKey {
+  fgElement* cell;
+  const char* text;
+  double number;
+};
+
+// Sorts an index permutation of the rows instead of the rows themselves, then applies it to the list in a single reorder.
+void fgGrid_Sort(fgGrid* self, size_t column, char flags, fgGridCompare compare, void* user)
+{
+  size_t n = self->list.box.order.ordered.l;
+  if(self->source.rows != 0 || !self->list.box.order.isordered || n < 2)
+    return;
+  fgElement** rows = self->list.box.order.ordered.p;
+  bss_util::cDynArray<fgGridSortKey> keys(n);
+  bss_util::cDynArray<size_t> perm(n);
+  keys.SetLength(n);
+  perm.SetLength(n);
+  for(size_t i = 0; i < n; ++i)
+  {
+    perm[i] = i;
+    keys[i].cell = rows[i]->GetItem(column);
+    keys[i].text = !keys[i].cell ? 0 : keys[i].cell->GetText();
+    if(!keys[i].text)
+      keys[i].text = "";
+    keys[i].number = (flags&FGGRID_SORT_NUMBER) ? strtod(keys[i].text, 0) : 0.0;
+  }
+
+  bool descending = (flags&FGGRID_SORT_DESCENDING) != 0;
+  std::stable_sort(perm.begin(), perm.end(), [&](size_t l, size_t r) -> bool {
+    int c;
+    if(compare != 0)
+      c = (*compare)(keys[l].cell, keys[r].cell, user);
+    else if(flags&FGGRID_SORT_NUMBER)
+      c = SGNCOMPARE(keys[l].number, keys[r].number);
+    else
+      c = strcmp(keys[l].text, keys[r].text);
+    return descending ? (c > 0) : (c < 0);
+  });
+
+  size_t first = 0;
+  while(first < n && perm[first] == first)
+    ++first;
+  if(first == n) // Already sorted
+    return;
+
+  bss_util::cDynArray<fgElement*> sorted(n);
+  bss_util::cDynArray<char> selected(n);
+  sorted.SetLength(n);
+  selected.SetLength(n);
+  size_t anchor = self->list.anchor;
+  for(size_t i = 0; i < n; ++i) // The selection is stored by index, so it has to follow the permutation
+  {
+    sorted[i] = rows[perm[i]];
+    selected[i] = self->list.selection.l > 0 && fgList_IsSelected(&self->list, perm[i]);
+    if(perm[i] == self->list.anchor)
+      anchor = i;
+  }
+
+  fgElement_ReorderChildren(*self, sorted.begin(), n, rows[n - 1]->next);
+
+  if(self->list.selection.l > 0)
+  {
+    bss_util::cDynArray<fgListRange> ranges;
+    for(size_t i = 0; i < n;)
+    {
+      if(!selected[i]) { ++i; continue; }
+      size_t start = i;
+      while(i < n && selected[i]) ++i;
+      ranges.Add(fgListRange { start, i });
+    }
+    fgList_SetSelection(&self->list, ranges.begin(), ranges.Length());
+  }
+  self->list.anchor = anchor;
+}
+
 size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
 {
   static fgTransform ROWTRANSFORM = fgTransform{ { 0, 0, 0, 0, 0, 1, 0, 0 }, 0, { 0,0,0,0 } };
@@ -38,6 +309,11 @@ size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
     fgList_Message(&self->list, msg);
     fgList_Init(&self->header, *self, 0, "Grid$header", FGELEMENT_BACKGROUND | FGELEMENT_EXPANDY | FGBOX_TILEX, &ROWTRANSFORM, 0);
     self->header->message = (fgMessage)fgGridColumn_Message;
+    memset(&self->source, 0, sizeof(fgGridSource));
+    memset(&self->tracks, 0, sizeof(self->tracks));
+    self->colstart = 0;
+    self->colend = 0;
+    self->trackversion = 0;
     return FG_ACCEPT;
   case FG_ADDITEM:
     switch(msg->subtype)
@@ -52,10 +328,33 @@ size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
         if(next) // We only have to insert a placeholder if there is actually an item that will come after us
           fgCreate("element", self->list, next, "Grid$placeholder", 0, &fgTransform_EMPTY, 0)->message = (fgMessage)&fgPlaceholder_Message;
       }
+      if(self->source.rows != 0)
+        fgGrid_Refresh(self);
+      else
+        fgGrid_UpdateTracks(self);
       return (size_t)text;
     }
     case FGITEM_ROW:
+      if(self->source.rows != 0)
+        return 0;
       return (size_t)fgCreate("gridrow", self->list, msg->u < self->list.box.order.ordered.l ? self->list.box.order.ordered.p[msg->u] : 0, "Grid$row", FGBOX_TILEX | FGELEMENT_EXPANDY, &ROWTRANSFORM, 0);
+    case FGITEM_TEXTARRAY: // Appends an array of columns. Nothing comes after them, so no placeholders are needed.
+    {
+      const char** items = (const char**)msg->p;
+      fgBoxOrderedElement_BeginBatch(&self->header.box.order, msg->u2);
+      for(size_t i = 0; i < msg->u2; ++i)
+        fgCreate("text", self->header, 0, "Grid$column", FGELEMENT_EXPAND, &fgTransform_EMPTY, 0)->SetText(items[i]);
+      fgBoxOrderedElement_EndBatch(&self->header.box.order, self->header);
+      if(self->source.rows != 0)
+        fgGrid_Refresh(self);
+      else
+        fgGrid_UpdateTracks(self);
+      return msg->u2;
+    }
+    case FGITEM_ELEMENTARRAY: // Appends an array of rows
+      if(self->source.rows != 0)
+        return 0;
+      return fgList_Message(&self->list, msg);
     }
     return 0;
   case FG_REMOVEITEM:
@@ -65,15 +364,25 @@ size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
       if(msg->u < self->header.box.order.ordered.l)
       {
         self->header->RemoveItem(msg->i);
-        for(size_t i = 0; i < self->list.box.order.ordered.l; ++i)
-          self->list.box.order.ordered.p[i]->RemoveItem(msg->i);
+        if(self->source.rows != 0)
+          fgGrid_Refresh(self);
+        else
+        {
+          for(size_t i = 0; i < self->list.box.order.ordered.l; ++i)
+            self->list.box.order.ordered.p[i]->RemoveItem(msg->i);
+          fgGrid_UpdateTracks(self);
+        }
         return FG_ACCEPT;
       }
       return 0;
     case FGITEM_ROW:
-      return self->list->RemoveItem(msg->u);
+      return (self->source.rows != 0) ? 0 : self->list->RemoveItem(msg->u);
+    case FGITEM_ELEMENTARRAY: // Removes an array of rows
+      return (self->source.rows != 0) ? 0 : fgList_Message(&self->list, msg);
     case 0:
     {
+      if(self->source.rows != 0)
+        return 0;
       fgElement* row = self->list->GetItem(msg->u2);
       if(row)
         return row->RemoveItem(msg->i);
@@ -87,8 +396,17 @@ size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
     case FGITEM_COLUMN:
       return (msg->u < self->header.box.order.ordered.l) ? (size_t)self->header.box.order.ordered.p[msg->u] : 0;
     case FGITEM_ROW:
+      if(self->source.rows != 0) // Only rows that are visible have an element
+        return fgList_Message(&self->list, msg);
       return (msg->u < self->list.box.order.ordered.l) ? (size_t)self->list.box.order.ordered.p[msg->u] : 0;
     case 0:
+      if(self->source.rows != 0)
+      {
+        fgGridRow* row = (fgGridRow*)_sendsubmsg<FG_GETITEM, ptrdiff_t>(*self, FGITEM_ROW, msg->u2);
+        if(!row || (size_t)msg->u < row->cellstart || (size_t)msg->u - row->cellstart >= row->cells.l)
+          return 0;
+        return (size_t)row->cells.p[msg->u - row->cellstart];
+      }
       if((size_t)msg->u2 < self->list.box.order.ordered.l)
         return _sendmsg<FG_GETITEM, ptrdiff_t>(self->list.box.order.ordered.p[msg->u2], msg->i);
       return 0;
@@ -130,32 +448,54 @@ size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg)
     }
     break;
   case FG_GETCLASSNAME:
-    return (size_t)"Grid";
+    return (size_t)FGSTR_GRID;
   case FG_ACTION:
     switch(msg->subtype)
     {
-    case FGGRID_RESIZECOLUMN:
+    case FGGRID_RESIZECOLUMN: // Update the shared track, which moves the cells of every row that exists
     {
       fgElement* c = msg->e;
-      size_t column = 0;
-      while(column < self->header.box.order.ordered.l && c != self->header.box.order.ordered.p[column])
-        ++column;
-      if(column >= self->header.box.order.ordered.l)
+      size_t column = c->orderindex;
+      if(column >= self->header.box.order.ordered.l || self->header.box.order.ordered.p[column] != c)
         return 0;
-      for(size_t i = 0; i < self->list.box.order.ordered.l; ++i)
+      if(self->tracks.l != self->header.box.order.ordered.l)
+        fgGrid_UpdateTracks(self);
+      else if(!fgGrid_UpdateTrack(self, column))
+        return FG_ACCEPT;
+      if(self->source.rows != 0)
       {
-        fgElement* p = self->list.box.order.ordered.p[i]->GetItem(column);
-        if(p)
-        {
-          CRect area = p->transform.area;
-          area.right.abs = area.left.abs + fgLayout_GetElementWidth(c); // TODO: Get opposite axis working
-          p->SetArea(area);
-        }
+        fgGrid_RealizeColumns(self, false);
+        fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
       }
+      fgroot_instance->backend.fgDirtyElement(*self);
     }
-
       return FG_ACCEPT;
     }
+    {
+      size_t r = fgList_Message(&self->list, msg);
+      if(self->source.rows != 0) // Scrolling horizontally changes which columns are visible
+        fgGrid_RealizeColumns(self, false);
+      else // Scrolling can bring rows with stale tracks into view
+        fgGrid_SyncRows(self);
+      return r;
+    }
+  case FG_MOVE:
+    {
+      size_t r = fgList_Message(&self->list, msg);
+      if(self->source.rows != 0)
+        fgGrid_RealizeColumns(self, false);
+      else
+        fgGrid_SyncRows(self);
+      return r;
+    }
+  case FG_LAYOUTFUNCTION:
+    if(self->source.rows != 0)
+    {
+      size_t r = fgList_Message(&self->list, msg);
+      if(msg->p2 != 0)
+        ((AbsVec*)msg->p2)->x = fgGrid_TotalWidth(self);
+      return r;
+    }
     break;
   }
 
@@ -171,12 +511,64 @@ inline fgElement* fgGridRowOrderInject(fgElement* self, const FG_Msg* msg)
   return fgOrderedVec<FLAGS>(&((fgGridRow*)self)->order, AbsVec { (FABS)msg->x, (FABS)msg->y });
 }
 
+inline fgGrid* fgGridRow_GetGrid(fgGridRow* self)
+{
+  fgElement* parent = self->element.parent;
+  return (parent != 0 && parent->GetClassName() == FGSTR_GRID) ? (fgGrid*)parent : 0;
+}
+
+// Places every cell of a row at its column's track, and returns the row's resulting dimensions in dim. Cells past the last column are placed after it using their own width.
+void fgGridRow_ApplyTracks(fgGrid* grid, fgGridRow* self, AbsVec* dim)
+{
+  FABS x = fgGrid_TotalWidth(grid);
+  FABS y = 0;
+  size_t column = self->cellstart;
+  size_t i = 0;
+  fgElement* cur = self->element.root;
+  for(;;)
+  {
+    if(self->cells.p != 0) // Virtual rows keep their cells in an array starting at cellstart
+      cur = (i < self->cells.l) ? self->cells.p[i++] : 0;
+    else
+      while(cur != 0 && (cur->flags&FGELEMENT_BACKGROUND))
+        cur = cur->next;
+    if(!cur)
+      break;
+
+    CRect& area = cur->transform.area;
+    FABS h = fgLayout_GetElementHeight(cur);
+    FABS w = (column < grid->tracks.l) ? grid->tracks.p[column].width : fgLayout_GetElementWidth(cur);
+    FABS left = (column < grid->tracks.l) ? grid->tracks.p[column].offset : x;
+    if(column >= grid->tracks.l)
+      x += w;
+    size_t diff = (area.left.abs != left ? FGMOVE_MOVEX : 0) | (area.top.abs != 0 ? FGMOVE_MOVEY : 0);
+    MoveCRect(left, 0, &area);
+    if(area.left.rel == area.right.rel && area.right.abs != left + w)
+    {
+      area.right.abs = left + w;
+      diff |= FGMOVE_RESIZEX;
+    }
+    if(diff) // Tell the cell it moved the same way a parent's move propagates down, so it doesn't bounce back up to us
+      _sendsubmsg<FG_MOVE, void*, size_t>(cur, FG_LAYOUTCHANGE, *self, diff);
+    if(area.top.rel == area.bottom.rel && h > y)
+      y = h;
+    ++column;
+    if(!self->cells.p)
+      cur = cur->next;
+  }
+
+  dim->x = x;
+  dim->y = y;
+  self->trackversion = grid->trackversion;
+}
+
 void fgGridRow_Init(fgGridRow* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units)
 {
   fgElement_InternalSetup(*self, parent, next, name, flags, transform, units, (fgDestroy)&fgGridRow_Destroy, (fgMessage)&fgGridRow_Message);
 }
 void fgGridRow_Destroy(fgGridRow* self)
 {
+  ((bss_util::cDynArray<fgElement*>&)self->cells).~cDynArray();
   fgElement_Destroy(&self->element);
   fgBoxOrderedElement_Destroy(&self->order);
 }
@@ -185,31 +577,34 @@ size_t fgGridRow_Message(fgGridRow* self, const FG_Msg* msg)
 {
   switch(msg->type)
   {
+  case FG_CONSTRUCT:
+    memset(&self->cells, 0, sizeof(fgVectorElement));
+    self->cellstart = 0;
+    self->index = 0;
+    self->trackversion = 0;
+    break;
   case FG_ADDITEM:
+    if(msg->subtype == FGITEM_TEXTARRAY && !self->cells.p) // Appends a text cell for each string
+    {
+      const char** items = (const char**)msg->p;
+      fgBoxOrderedElement_BeginBatch(&self->order, msg->u2);
+      for(size_t i = 0; i < msg->u2; ++i)
+        fgCreate("text", *self, 0, 0, FGELEMENT_EXPAND, &fgTransform_EMPTY, 0)->SetText(items[i]);
+      fgBoxOrderedElement_EndBatch(&self->order, *self);
+      return msg->u2;
+    }
     break;
-  case FG_ADDCHILD:
-    if(self->element.parent != 0 && !(((fgElement*)msg->p)->flags&FGELEMENT_BACKGROUND))
+  case FG_LAYOUTFUNCTION: // Inside a grid, the cells are placed at the shared column tracks instead of being tiled by their own widths
+    if(fgGrid* grid = fgGridRow_GetGrid(self))
     {
-      int column = 0;
-      fgElement* e = self->element.root;
-      fgElement* next = msg->e2;
-      while(e != next)
-      {
-        column += !(e->flags&FGELEMENT_BACKGROUND);
-        e = e->next;
-      }
-      fgElement* c = reinterpret_cast<fgElement*>(_sendsubmsg<FG_GETITEM, ptrdiff_t>(self->element.parent, FGITEM_COLUMN, column));
-      if(c)
-      {
-        fgElement* child = msg->e;
-        CRect area = child->transform.area;
-        area.right.abs = area.left.abs + fgLayout_GetElementWidth(c); // TODO: Get opposite axis working
-        child->SetArea(area);
-      }
+      if(msg->p2 != 0)
+        fgGridRow_ApplyTracks(grid, self, (AbsVec*)msg->p2);
+      fgroot_instance->backend.fgDirtyElement(*self);
+      return FG_ACCEPT;
     }
     break;
-  case FG_DRAW:
-    if(!self->order.isordered || !self->order.ordered.l)
+  case FG_DRAW: // Virtual rows recycle their cells out of order, so they always use the standard draw
+    if(!self->order.isordered || !self->order.ordered.l || self->cells.p != 0)
       fgStandardDraw(*self, (AbsRect*)msg->p, (fgDrawAuxData*)msg->p2, msg->subtype & 1);
     else
     {
@@ -226,7 +621,7 @@ size_t fgGridRow_Message(fgGridRow* self, const FG_Msg* msg)
     }
     return FG_ACCEPT;
   case FG_INJECT:
-    if(!self->order.isordered || !self->order.ordered.l)
+    if(!self->order.isordered || !self->order.ordered.l || self->cells.p != 0)
       return fgStandardInject(*self, (const FG_Msg*)msg->p, (const AbsRect*)msg->p2);
     else
     {
@@ -257,6 +652,7 @@ bool fgGrid::RemoveItem(size_t column, size_t row) { return _sendsubmsg<FG_REMOV
 fgElement* fgGrid::GetItem(size_t column, size_t row) { return reinterpret_cast<fgElement*>(_sendsubmsg<FG_GETITEM, ptrdiff_t>(*this, 0, column, row)); }
 fgGridRow* fgGrid::GetRow(size_t row) { return reinterpret_cast<fgGridRow*>(_sendsubmsg<FG_GETITEM, ptrdiff_t>(*this, FGITEM_ROW, row)); }
 fgElement* fgGrid::GetColumn(size_t column) { return reinterpret_cast<fgElement*>(_sendsubmsg<FG_GETITEM, ptrdiff_t>(*this, FGITEM_COLUMN, column)); }
+void fgGrid::Sort(size_t column, char flags, fgGridCompare compare, void* user) { fgGrid_Sort(this, column, flags, compare, user); }
 
 void fgGridRow::InsertItem(fgElement* item, size_t column) { _sendmsg<FG_ADDITEM, void*, size_t>(*this, item, column); }
 void fgGridRow::InsertItem(const char* item, size_t column) { _sendmsg<FG_ADDITEM, const void*, size_t>(*this, item, column); }
@@ -307,10 +307,9 @@ size_t fgTileLayout(fgElement* self, const FG_Msg* msg, fgFlag flags, AbsVec* di
       curdim = fgTileLayoutReorder(self->root, 0, axis, max, AbsVec{ 0,0 }, flags);
     else
     {
-      fgElement* old = msg->e2;
+      fgElement* old = msg->e2; // If old is the same as child, a block of children moved and child is the first position that changed
       fgElement* cur = old;
-      assert(!(old->flags&FGELEMENT_BACKGROUND));
-      assert(!(cur->flags&FGELEMENT_BACKGROUND));
+      assert(!old || !(old->flags&FGELEMENT_BACKGROUND));
       while(cur != 0 && cur != child) cur = cur->next; // Run down from old until we either hit child, in which case old is the lowest, or we hit null
       curdim = fgTileLayoutReorder(!cur ? child : old, 0, axis, max, curdim, flags);
     }
@@ -6,9 +6,10 @@
 #include "fgCurve.h"
 #include "bss-util/bss_util.h"
 #include "feathercpp.h"
+#include <algorithm>
 
 static const char* FGSTR_LISTITEM = "ListItem";
-typedef bss_util::cArraySort<fgElement*> fgElementArray;
+typedef bss_util::cDynArray<fgListRange> fgListRanges;
 
 void fgListItem_Init(fgControl* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units)
 {
@@ -53,23 +54,545 @@ void fgList_Init(fgList* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RE
 }
 void fgList_Destroy(fgList* self)
 {
-  ((fgElementArray&)self->selected).~cArraySort();
+  fgTypeahead_Destroy(&self->typeahead);
+  ((fgListRanges&)self->selection).~cDynArray();
+  ((bss_util::cDynArray<fgElement*>&)self->pool).~cDynArray(); // The pooled elements are children, so they get destroyed along with everything else.
   self->box->message = (fgMessage)fgBox_Message;
   fgBox_Destroy(&self->box);
 }
-void fgList_Draw(fgElement* self, const AbsRect* area, const fgDrawAuxData* data)
+static const double FGTYPEAHEAD_TIMEOUT = 1.0; // Seconds without a keystroke before the typed prefix is forgotten
+
+inline char fgTypeahead_Fold(char c) { return (c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c; }
+
+char fgTypeahead_Clear(void* p)
 {
-  fgList* realself = reinterpret_cast<fgList*>(self);
-  for(size_t i = 0; i < realself->selected.l; ++i)
+  ((fgTypeahead*)p)->prefix.l = 0;
+  return 0; // We own the action, so it shouldn't be deallocated
+}
+
+void fgTypeahead_Init(fgTypeahead* self)
+{
+  memset(self, 0, sizeof(fgTypeahead));
+  self->dirty = 1;
+}
+
+void fgTypeahead_Destroy(fgTypeahead* self)
+{
+  if(self->timeout != 0)
+    fgRoot_DeallocAction(fgroot_instance, self->timeout);
+  ((bss_util::cDynArray<fgTypeaheadEntry>&)self->entries).~cDynArray();
+  ((bss_util::cDynArray<char>&)self->keys).~cDynArray();
+  ((bss_util::cDynArray<char>&)self->prefix).~cDynArray();
+  ((bss_util::cDynArray<fgElement*>&)self->pending).~cDynArray();
+  self->timeout = 0;
+}
+
+// Items like ListItem are containers, so if the item itself has no text we use the first child that does.
+inline const char* fgTypeahead_GetText(fgElement* item)
+{
+  const char* text = item->GetText();
+  for(fgElement* cur = item->root; (!text || !text[0]) && cur != 0; cur = cur->next)
+    text = cur->GetText();
+  return text;
+}
+
+// Appends the case-folded text of item to the key buffer and returns its offset, or -1 if the item has no text.
+size_t fgTypeahead_AppendKey(fgTypeahead* self, fgElement* item)
+{
+  const char* text = fgTypeahead_GetText(item);
+  if(!text)
+    return (size_t)~0;
+  bss_util::cDynArray<char>& keys = (bss_util::cDynArray<char>&)self->keys;
+  size_t offset = keys.Length();
+  for(; *text; ++text)
+    keys.Add(fgTypeahead_Fold(*text));
+  keys.Add(0);
+  return offset;
+}
+
+// Returns the first entry whose key isn't less than the first n characters of key.
+inline size_t fgTypeahead_Lower(fgTypeahead* self, size_t key, size_t n)
+{
+  size_t lo = 0;
+  size_t hi = self->entries.l;
+  while(lo < hi)
+  {
+    size_t mid = lo + ((hi - lo) >> 1);
+    if(strncmp(self->keys.p + self->entries.p[mid].offset, self->keys.p + key, n) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Checks that an entry's key still matches the text of its item.
+inline bool fgTypeahead_IsCurrent(fgTypeahead* self, const fgTypeaheadEntry& entry)
+{
+  const char* text = fgTypeahead_GetText(entry.item);
+  const char* key = self->keys.p + entry.offset;
+  if(!text)
+    return false;
+  for(; *text && *key; ++text, ++key)
+    if(fgTypeahead_Fold(*text) != *key)
+      return false;
+  return !*text && !*key;
+}
+
+void fgTypeahead_Rebuild(fgTypeahead* self, fgElement* parent)
+{
+  bss_util::cDynArray<fgTypeaheadEntry>& entries = (bss_util::cDynArray<fgTypeaheadEntry>&)self->entries;
+  entries.Clear();
+  self->keys.l = 0;
+  self->pending.l = 0;
+  self->garbage = 0;
+  for(fgElement* cur = parent->root; cur != 0; cur = cur->next)
   {
-    if(realself->selected.p[i]->GetClassName() != FGSTR_LISTITEM)
+    if(cur->flags&FGELEMENT_BACKGROUND)
+      continue;
+    size_t offset = fgTypeahead_AppendKey(self, cur);
+    if(offset != (size_t)~0)
+      entries.Add(fgTypeaheadEntry { offset, cur });
+  }
+  const char* k = self->keys.p; // The key buffer won't move once we're done adding to it
+  std::stable_sort(entries.begin(), entries.end(), [k](const fgTypeaheadEntry& l, const fgTypeaheadEntry& r) { return strcmp(k + l.offset, k + r.offset) < 0; });
+  self->dirty = 0;
+}
+
+// Keys an item that was added since the index was built. Items with the same key stay in child order.
+void fgTypeahead_Insert(fgTypeahead* self, fgElement* item)
+{
+  size_t offset = fgTypeahead_AppendKey(self, item);
+  if(offset == (size_t)~0)
+    return;
+  size_t i = fgTypeahead_Lower(self, offset, (size_t)~0);
+  while(i < self->entries.l && !strcmp(self->keys.p + self->entries.p[i].offset, self->keys.p + offset) && self->entries.p[i].item->orderindex < item->orderindex)
+    ++i;
+  ((bss_util::cDynArray<fgTypeaheadEntry>&)self->entries).Insert(fgTypeaheadEntry { offset, item }, i);
+}
+
+void fgTypeahead_Add(fgTypeahead* self, fgElement* item)
+{
+  if(!self->dirty && !(item->flags&FGELEMENT_BACKGROUND))
+    ((bss_util::cDynArray<fgElement*>&)self->pending).Add(item); // The item's text often isn't set until after it's added, so it's keyed on the next search
+}
+
+void fgTypeahead_Remove(fgTypeahead* self, fgElement* item)
+{
+  if(self->dirty || (item->flags&FGELEMENT_BACKGROUND))
+    return;
+  for(size_t i = 0; i < self->pending.l; ++i)
+    if(self->pending.p[i] == item)
+    {
+      ((bss_util::cDynArray<fgElement*>&)self->pending).Remove(i);
+      return;
+    }
+
+  size_t end = self->keys.l; // The item's current text is usually the text it was keyed with, so try finding it with that first
+  size_t key = fgTypeahead_AppendKey(self, item);
+  size_t i = self->entries.l;
+  if(key != (size_t)~0)
+    for(i = fgTypeahead_Lower(self, key, (size_t)~0); i < self->entries.l && !strcmp(self->keys.p + self->entries.p[i].offset, self->keys.p + key); ++i)
+      if(self->entries.p[i].item == item)
+        break;
+  self->keys.l = end;
+  if(i >= self->entries.l || self->entries.p[i].item != item)
+    for(i = 0; i < self->entries.l && self->entries.p[i].item != item; ++i);
+  if(i >= self->entries.l)
+    return;
+
+  self->garbage += strlen(self->keys.p + self->entries.p[i].offset) + 1;
+  ((bss_util::cDynArray<fgTypeaheadEntry>&)self->entries).Remove(i);
+  if(self->garbage > (self->keys.l >> 1)) // Removed keys are left in the buffer until they take up most of it
+    self->dirty = 1;
+}
+
+fgElement* fgTypeahead_Search(fgTypeahead* self, fgBox* parent, int keychar)
+{
+  if(self->dirty || (self->pending.l > 0 && !parent->order.isordered)) // Items are only inserted in child order if the box keeps their order index up to date
+    fgTypeahead_Rebuild(self, *parent);
+  for(size_t i = 0; i < self->pending.l; ++i)
+    fgTypeahead_Insert(self, self->pending.p[i]);
+  self->pending.l = 0;
+  if(!self->timeout)
+    self->timeout = fgRoot_AllocAction(&fgTypeahead_Clear, self, 0.0);
+  self->timeout->time = fgroot_instance->time + FGTYPEAHEAD_TIMEOUT;
+  fgRoot_ModifyAction(fgroot_instance, self->timeout);
+
+  char buf[4];
+  size_t len = fgUTF32toUTF8(&keychar, 1, buf, 4);
+  bss_util::cDynArray<char>& prefix = (bss_util::cDynArray<char>&)self->prefix;
+  for(size_t i = 0; i < len; ++i)
+    prefix.Add(fgTypeahead_Fold(buf[i]));
+
+  size_t end = self->keys.l; // The prefix is put at the end of the key buffer so it can be compared the same way as a key
+  for(size_t i = 0; i < prefix.Length(); ++i)
+    ((bss_util::cDynArray<char>&)self->keys).Add(prefix[i]);
+  fgElement* item = 0;
+  for(int pass = 0; pass < 2 && !item; ++pass)
+  {
+    size_t i = fgTypeahead_Lower(self, end, prefix.Length());
+    if(i >= self->entries.l || strncmp(self->keys.p + self->entries.p[i].offset, self->keys.p + end, prefix.Length()) != 0)
+      break;
+    if(pass > 0 || fgTypeahead_IsCurrent(self, self->entries.p[i]))
+      item = self->entries.p[i].item;
+    else // The item's text changed after it was keyed, so the whole index is suspect
+    {
+      fgTypeahead_Rebuild(self, *parent);
+      end = self->keys.l;
+      for(size_t j = 0; j < prefix.Length(); ++j)
+        ((bss_util::cDynArray<char>&)self->keys).Add(prefix[j]);
+    }
+  }
+  self->keys.l = end;
+  return item;
+}
+
+// Returns the first selected range that ends after index
+inline size_t fgList_LowerRange(fgList* self, size_t index)
+{
+  size_t lo = 0;
+  size_t hi = self->selection.l;
+  while(lo < hi)
+  {
+    size_t mid = lo + ((hi - lo) >> 1);
+    if(self->selection.p[mid].end <= index)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Returns the first selected range that starts at or after index
+inline size_t fgList_UpperRange(fgList* self, size_t index)
+{
+  size_t lo = 0;
+  size_t hi = self->selection.l;
+  while(lo < hi)
+  {
+    size_t mid = lo + ((hi - lo) >> 1);
+    if(self->selection.p[mid].start < index)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+char fgList_IsSelected(fgList* self, size_t index)
+{
+  size_t i = fgList_LowerRange(self, index);
+  return i < self->selection.l && self->selection.p[i].start <= index;
+}
+
+void fgList_ApplySelection(fgList* self);
+
+// Replaces the ranges [i, j) with the n given ranges, then merges any ranges around them that ended up touching.
+void fgList_SpliceRanges(fgList* self, size_t i, size_t j, const fgListRange* ranges, size_t n)
+{
+  fgListRanges& selection = (fgListRanges&)self->selection;
+  if(n > j - i)
+    selection.Reserve(selection.Length() + n - (j - i));
+  fgListRange* p = self->selection.p;
+  memmove(p + i + n, p + j, (self->selection.l - j) * sizeof(fgListRange));
+  memcpy(p + i, ranges, n * sizeof(fgListRange));
+  self->selection.l = self->selection.l + n - (j - i);
+
+  size_t k = (i > 0) ? i - 1 : 0;
+  size_t end = bssmin(i + n + 1, self->selection.l);
+  while(k + 1 < end)
+  {
+    if(p[k].end >= p[k + 1].start)
+    {
+      p[k].end = bssmax(p[k].end, p[k + 1].end);
+      bss_util::RemoveRangeSimple<fgListRange>(p, self->selection.l, k + 1, (size_t)1);
+      --self->selection.l;
+      --end;
+    }
+    else
+      ++k;
+  }
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+void fgList_SelectRange(fgList* self, size_t start, size_t end, char select)
+{
+  if(start >= end)
+    return;
+  size_t i = fgList_LowerRange(self, start);
+  size_t j = fgList_UpperRange(self, end);
+  if(j < i) j = i;
+  fgListRange* p = self->selection.p;
+  if(select)
+  {
+    fgListRange r = { start, end };
+    if(i < j)
+    {
+      r.start = bssmin(start, p[i].start);
+      r.end = bssmax(end, p[j - 1].end);
+    }
+    fgList_SpliceRanges(self, i, j, &r, 1);
+  }
+  else
+  {
+    fgListRange r[2];
+    size_t n = 0;
+    if(i < j && p[i].start < start)
+      r[n++] = fgListRange { p[i].start, start };
+    if(i < j && p[j - 1].end > end)
+      r[n++] = fgListRange { end, p[j - 1].end };
+    fgList_SpliceRanges(self, i, j, r, n);
+  }
+  fgList_ApplySelection(self);
+}
+
+void fgList_InvertRange(fgList* self, size_t start, size_t end)
+{
+  if(start >= end)
+    return;
+  size_t i = fgList_LowerRange(self, start);
+  size_t j = fgList_UpperRange(self, end);
+  if(j < i) j = i;
+  fgListRange* p = self->selection.p;
+  fgListRanges r;
+  if(i < j && p[i].start < start)
+    r.Add(fgListRange { p[i].start, start });
+  size_t cur = start;
+  for(size_t k = i; k < j; ++k)
+  {
+    if(p[k].start > cur)
+      r.Add(fgListRange { cur, p[k].start });
+    cur = bssmin(p[k].end, end);
+  }
+  if(cur < end)
+    r.Add(fgListRange { cur, end });
+  if(i < j && p[j - 1].end > end)
+    r.Add(fgListRange { end, p[j - 1].end });
+  fgList_SpliceRanges(self, i, j, r.begin(), r.Length());
+  fgList_ApplySelection(self);
+}
+
+void fgList_ClearSelection(fgList* self)
+{
+  self->selection.l = 0;
+  fgList_ApplySelection(self);
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+void fgList_SetSelection(fgList* self, const fgListRange* ranges, size_t n)
+{
+  self->selection.l = 0;
+  fgList_SpliceRanges(self, 0, 0, ranges, n);
+  fgList_ApplySelection(self);
+}
+
+// Keeps the selection attached to the same items when an unselected item is inserted at index, or the item at index is removed.
+void fgList_ShiftSelection(fgList* self, size_t index, bool insert)
+{
+  size_t i = fgList_LowerRange(self, index);
+  if(i >= self->selection.l)
+    return;
+  fgListRange* p = self->selection.p;
+  if(insert)
+  {
+    if(p[i].start < index) // Split the range we're inserting into
+    {
+      fgListRange r[2] = { { p[i].start, index }, { index + 1, p[i].end + 1 } };
+      for(size_t k = i + 1; k < self->selection.l; ++k)
+      {
+        ++p[k].start;
+        ++p[k].end;
+      }
+      ((fgListRanges&)self->selection).Reserve(self->selection.l + 1);
+      p = self->selection.p;
+      memmove(p + i + 2, p + i + 1, (self->selection.l - i - 1) * sizeof(fgListRange));
+      p[i] = r[0];
+      p[i + 1] = r[1];
+      ++self->selection.l;
+    }
+    else
+      for(size_t k = i; k < self->selection.l; ++k)
+      {
+        ++p[k].start;
+        ++p[k].end;
+      }
+    return;
+  }
+
+  for(size_t k = i; k < self->selection.l; ++k)
+  {
+    if(p[k].start > index)
+      --p[k].start;
+    --p[k].end;
+  }
+  if(p[i].start == p[i].end)
+    fgList_SpliceRanges(self, i, i + 1, 0, 0);
+  else if(i > 0 && p[i - 1].end == p[i].start) // Removing an unselected item can join two ranges
+    fgList_SpliceRanges(self, i, i, 0, 0);
+}
+
+// Returns the index of a child item, or -1 if it isn't one. Ordered children know their own index, but tile layouts also keep the ordered array sorted by position, so we can binary search it.
+size_t fgList_IndexOf(fgList* self, fgElement* item)
+{
+  if(self->source.count != 0)
+  {
+    for(size_t i = 0; i < self->pool.l; ++i)
+      if(self->pool.p[i] == item)
+        return self->poolstart + i;
+    return (size_t)~0;
+  }
+  if(self->box.order.isordered && self->box.order.ordered.l > 0)
+  {
+    if(item->orderindex < self->box.order.ordered.l && self->box.order.ordered.p[item->orderindex] == item)
+      return item->orderindex;
+    fgFlag flags = self->box->flags&(FGBOX_TILE | FGBOX_DISTRIBUTEY);
+    bool columns = (flags == FGBOX_TILEX || flags == (FGBOX_TILE | FGBOX_DISTRIBUTEY));
+    auto key = [columns, flags](fgElement* e) -> AbsVec {
+      AbsVec v = { e->transform.area.top.abs, e->transform.area.left.abs };
+      if(columns) std::swap(v.x, v.y);
+      if(flags != FGBOX_TILE && flags != (FGBOX_TILE | FGBOX_DISTRIBUTEY)) v.y = 0; // Only 2D tiling has a secondary axis
+      return v;
+    };
+    AbsVec k = key(item);
+    fgElement** p = self->box.order.ordered.p;
+    size_t lo = 0;
+    size_t hi = self->box.order.ordered.l;
+    while(lo < hi)
+    {
+      size_t mid = lo + ((hi - lo) >> 1);
+      AbsVec m = key(p[mid]);
+      if(m.x < k.x || (m.x == k.x && m.y < k.y))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    for(; lo < self->box.order.ordered.l && p[lo] != item; ++lo) // Zero-sized items can share a position
+    {
+      AbsVec m = key(p[lo]);
+      if(m.x != k.x || m.y != k.y)
+        break;
+    }
+    if(lo < self->box.order.ordered.l && p[lo] == item)
+      return lo;
+    for(size_t i = 0; i < self->box.order.ordered.l; ++i) // If the layout hasn't caught up yet, fall back to a linear search
+      if(p[i] == item)
+        return i;
+    return (size_t)~0;
+  }
+  size_t i = 0;
+  for(fgElement* cur = self->box->root; cur != 0; cur = cur->next)
+  {
+    if(cur == item)
+      return i;
+    i += !(cur->flags&FGELEMENT_BACKGROUND);
+  }
+  return (size_t)~0;
+}
+
+// Returns the item at index, or NULL. An unordered box can't look items up by index, so we walk the children the same way fgList_IndexOf does.
+fgElement* fgList_ItemAt(fgList* self, size_t index)
+{
+  if(self->source.count != 0 || self->box.order.isordered)
+    return (*self)->GetItem(index);
+  for(fgElement* cur = self->box->root; cur != 0; cur = cur->next)
+    if(!(cur->flags&FGELEMENT_BACKGROUND) && !index--)
+      return cur;
+  return 0;
+}
+
+size_t fgList_Count(fgList* self)
+{
+  if(self->source.count != 0)
+    return self->count;
+  if(self->box.order.isordered)
+    return self->box.order.ordered.l;
+  size_t n = 0;
+  for(fgElement* cur = self->box->root; cur != 0; cur = cur->next)
+    n += !(cur->flags&FGELEMENT_BACKGROUND);
+  return n;
+}
+
+// Calls f on every item that could be visible inside both area and clip, along with its index.
+template<typename F>
+void fgList_ForEachVisible(fgList* self, const AbsRect* area, const AbsRect* clip, F f)
+{
+  if(self->source.count != 0)
+  {
+    for(size_t i = 0; i < self->pool.l; ++i)
+      f(self->pool.p[i], self->poolstart + i);
+    return;
+  }
+  if(self->box.order.isordered && self->box.order.ordered.l > 0)
+  {
+    fgFlag flags = self->box->flags&(FGBOX_TILE | FGBOX_DISTRIBUTEY);
+    bool columns = (flags == FGBOX_TILEX || flags == (FGBOX_TILE | FGBOX_DISTRIBUTEY));
+    AbsRect out;
+    fgRectIntersection(area, clip, &out);
+    for(size_t i = fgBoxOrderedElement_GetVisible(&self->box.order, self->box->flags, &out, area); i < self->box.order.ordered.l; ++i)
     {
       AbsRect r;
-      ResolveRectCache(realself->selected.p[i], &r, area, (realself->selected.p[i]->flags & FGELEMENT_BACKGROUND) ? 0 : &self->padding);
-      fgSnapAbsRect(r, self->flags);
-      fgroot_instance->backend.fgDrawAsset(0, &CRect_EMPTY, realself->select.color, 0, 0.0f, &r, 0.0f, &AbsVec_EMPTY, FGRESOURCE_RECT, data);
+      ResolveRectCache(self->box.order.ordered.p[i], &r, area, &self->box->padding);
+      if(columns ? (r.left > out.right) : (r.top > out.bottom))
+        break;
+      f(self->box.order.ordered.p[i], i);
     }
+    return;
+  }
+  size_t i = 0;
+  for(fgElement* cur = self->box->root; cur != 0; cur = cur->next)
+    if(!(cur->flags&FGELEMENT_BACKGROUND))
+      f(cur, i++);
+}
+
+// List items style themselves, so instead of pushing a style change to every item whenever the selection changes, only visible items are updated.
+// This is called whenever the selection or the visible range changes. Changing a style can move items around, so the items are gathered before any are touched.
+void fgList_ApplySelection(fgList* self)
+{
+  if(self->box.order.batch > 0) // A bulk removal leaves holes in the ordered array until it ends, and ending the batch resets the layout, which applies this
+    return;
+  if(!self->selection.l && !self->styled) // Nothing is selected and nothing still looks selected
+    return;
+  struct Item { fgElement* e; size_t index; };
+  FG_UINT flag = fgStyle_GetName("selected", true);
+  bss_util::cDynArray<Item> items;
+  AbsRect area;
+  ResolveRect(*self, &area);
+  fgList_ForEachVisible(self, &area, &area, [self, flag, &items](fgElement* e, size_t index) {
+    if(e->GetClassName() != FGSTR_LISTITEM)
+      return;
+    bool current = (e->style != (FG_UINT)-1) && (e->style&flag) != 0;
+    if(current != (fgList_IsSelected(self, index) != 0))
+      items.Add(Item { e, index });
+  });
+  for(size_t i = 0; i < items.Length(); ++i)
+  {
+    bool selected = fgList_IsSelected(self, items[i].index) != 0;
+    self->styled += selected ? 1 : -1;
+    fgStandardNeutralSetStyle(items[i].e, "selected", selected ? FGSETSTYLE_SETFLAG : FGSETSTYLE_REMOVEFLAG);
   }
+}
+
+// Returns true if the list gave this item the selected style.
+inline bool fgList_IsStyled(fgElement* e)
+{
+  return e->GetClassName() == FGSTR_LISTITEM && e->style != (FG_UINT)-1 && (e->style&fgStyle_GetName("selected", true)) != 0;
+}
+
+void fgList_Draw(fgElement* self, const AbsRect* area, const fgDrawAuxData* data)
+{
+  fgList* realself = reinterpret_cast<fgList*>(self);
+  AbsRect clip = fgroot_instance->backend.fgPeekClipRect(data);
+  if(realself->selection.l > 0)
+    fgList_ForEachVisible(realself, area, &clip, [realself, self, area, data](fgElement* e, size_t index) {
+      if(e->GetClassName() != FGSTR_LISTITEM && fgList_IsSelected(realself, index))
+      {
+        AbsRect r;
+        ResolveRectCache(e, &r, area, (e->flags & FGELEMENT_BACKGROUND) ? 0 : &self->padding);
+        fgSnapAbsRect(r, self->flags);
+        fgroot_instance->backend.fgDrawAsset(0, &CRect_EMPTY, realself->select.color, 0, 0.0f, &r, 0.0f, &AbsVec_EMPTY, FGRESOURCE_RECT, data);
+      }
+    });
 
   if(realself->mouse.state&FGMOUSE_DRAG)
   {
@@ -126,6 +649,149 @@ fgElement* fgList_GetSplit(fgList* self, const FG_Msg* msg)
   return 0;
 }
 
+inline bool fgList_Horizontal(fgList* self) { return (self->box->flags&FGBOX_TILE) == FGBOX_TILEX; }
+
+inline void fgList_PlaceItem(fgList* self, fgElement* item, size_t index)
+{
+  FABS pos = index*self->itemsize;
+  if(fgList_Horizontal(self))
+    item->SetArea(CRect { pos, 0, 0, 0, pos + self->itemsize, 0, 0, 1 });
+  else
+    item->SetArea(CRect { 0, 0, pos, 0, 0, 1, pos + self->itemsize, 0 });
+}
+
+// Binds an item to the given element, creating a new one if item is NULL. If we don't know the item size, the element expands to fit its contents so it can be measured.
+fgElement* fgList_BindItem(fgList* self, fgElement* item, size_t index)
+{
+  if(!item)
+  {
+    fgFlag flags = (self->itemsize > 0) ? 0 : (fgList_Horizontal(self) ? FGELEMENT_EXPANDX : FGELEMENT_EXPANDY);
+    item = fgroot_instance->backend.fgCreate(!self->source.type ? FGSTR_LISTITEM : self->source.type, *self, 0, 0, flags, &fgTransform_EMPTY, 0);
+  }
+  self->source.bind(self->source.user, item, index);
+  return item;
+}
+
+// Makes sure exactly the visible items plus an overscan on either side have an element, recycling elements that scrolled out of view.
+void fgList_Realize(fgList* self, bool rebind)
+{
+  static const size_t OVERSCAN = 4;
+  if(!self->source.count)
+    return;
+  bool horizontal = fgList_Horizontal(self);
+  bss_util::cDynArray<fgElement*>& pool = (bss_util::cDynArray<fgElement*>&)self->pool;
+  FABS oldsize = self->itemsize;
+  FABS fixed = horizontal ? self->box.order.fixedsize.x : self->box.order.fixedsize.y;
+  if(fixed > 0 && fixed != self->itemsize)
+  {
+    self->itemsize = fixed;
+    rebind = true; // every element has to be moved
+  }
+  if(self->itemsize <= 0 && self->count > 0) // Estimate the size of every item from the size of the first one.
+  {
+    if(!pool.Length())
+    {
+      pool.Add(fgList_BindItem(self, 0, 0));
+      self->poolstart = 0;
+    }
+    const CRect& area = pool[0]->transform.area;
+    self->itemsize = horizontal ? (area.right.abs - area.left.abs) : (area.bottom.abs - area.top.abs);
+    if(self->itemsize <= 0)
+      self->itemsize = self->box->GetLineHeight();
+    rebind = true;
+  }
+  if(self->itemsize != oldsize)
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+  if(!self->count || self->itemsize <= 0) // Nothing to show, or no size to divide the view by
+  {
+    for(size_t i = 0; i < pool.Length(); ++i)
+      VirtualFreeChild(pool[i]);
+    pool.Clear();
+    self->poolstart = 0;
+    return;
+  }
+
+  AbsRect r;
+  ResolveRect(*self, &r);
+  FABS offset = horizontal ? (self->box.scroll.realpadding.left - self->box->padding.left) : (self->box.scroll.realpadding.top - self->box->padding.top);
+  FABS extent = horizontal ? (r.right - r.left) : (r.bottom - r.top);
+  size_t start = (offset > 0) ? (size_t)(offset / self->itemsize) : 0;
+  size_t end = (size_t)ceilf(bssmax(offset + extent, 0.0f) / self->itemsize);
+  start = (start > OVERSCAN) ? start - OVERSCAN : 0;
+  end = bssmin(end + OVERSCAN, self->count);
+  if(start > end)
+    start = end;
+  if(!rebind && start == self->poolstart && end == self->poolstart + pool.Length())
+    return;
+
+  bss_util::cDynArray<fgElement*> items(end - start);
+  bss_util::cDynArray<fgElement*> recycle;
+  items.SetLength(end - start);
+  for(size_t i = 0; i < items.Length(); ++i)
+    items[i] = 0;
+  for(size_t i = 0; i < pool.Length(); ++i)
+  {
+    size_t index = self->poolstart + i;
+    if(!rebind && index >= start && index < end)
+      items[index - start] = pool[i];
+    else
+      recycle.Add(pool[i]);
+  }
+  for(size_t i = 0; i < items.Length(); ++i)
+  {
+    if(!items[i])
+    {
+      fgElement* item = 0;
+      if(recycle.Length() > 0)
+      {
+        item = recycle.Back();
+        recycle.RemoveLast();
+      }
+      items[i] = fgList_BindItem(self, item, start + i);
+      fgList_PlaceItem(self, items[i], start + i);
+    }
+  }
+  for(size_t i = 0; i < recycle.Length(); ++i) // Only happens if the visible area shrank
+    VirtualFreeChild(recycle[i]);
+  pool = std::move(items);
+  self->poolstart = start;
+  fgList_ApplySelection(self); // Recycled elements still have the style of whatever item they displayed before
+}
+
+void fgList_SetSource(fgList* self, const fgListSource* source)
+{
+  bss_util::cDynArray<fgElement*>& pool = (bss_util::cDynArray<fgElement*>&)self->pool;
+  for(size_t i = 0; i < pool.Length(); ++i)
+    VirtualFreeChild(pool[i]);
+  pool.Clear();
+  self->selection.l = 0;
+  self->poolstart = 0;
+  self->count = 0;
+  self->itemsize = 0;
+  if(source != 0)
+    self->source = *source;
+  else
+    memset(&self->source, 0, sizeof(fgListSource));
+  fgList_Refresh(self);
+}
+
+void fgList_Refresh(fgList* self)
+{
+  self->count = !self->source.count ? 0 : self->source.count(self->source.user);
+  fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+  fgList_Realize(self, true);
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+// The item is built before it's added so the list only applies its skin once, after the text is in place.
+fgElement* fgList_AddTextItem(fgList* self, const char* text, FGTEXTFMT fmt)
+{
+  fgElement* item = fgroot_instance->backend.fgCreate(FGSTR_LISTITEM, 0, 0, 0, FGELEMENT_EXPAND, &fgTransform_EMPTY, 0);
+  fgroot_instance->backend.fgCreate("Text", item, 0, 0, FGELEMENT_EXPAND, &fgTransform_EMPTY, 0)->SetText(text, fmt);
+  self->box->AddChild(item, 0);
+  return item;
+}
+
 size_t fgList_Message(fgList* self, const FG_Msg* msg)
 {
   ptrdiff_t otherint = msg->i;
@@ -133,9 +799,14 @@ size_t fgList_Message(fgList* self, const FG_Msg* msg)
 
   switch(msg->type)
   {
-  case FG_CONSTRUCT:
+  case FG_CONSTRUCT: // The box sends us messages while it constructs its scrollbars, so everything our handlers read has to be zeroed first
+    memset(&self->box.order, 0, sizeof(self->box.order));
+    memset(&self->selection, 0, sizeof(self->selection));
+    memset(&self->source, 0, sizeof(fgListSource));
+    memset(&self->pool, 0, sizeof(fgVectorElement));
+    self->styled = 0;
     fgBox_Message(&self->box, msg);
-    memset(&self->selected, 0, sizeof(fgVectorElement));
+    self->anchor = 0;
     memset(&self->mouse, 0, sizeof(fgMouseState));
     self->box.fndraw = &fgList_Draw;
     self->select.color = 0xFF9999DD;
@@ -145,6 +816,10 @@ size_t fgList_Message(fgList* self, const FG_Msg* msg)
     self->split = 0;
     self->splitedge = 0;
     self->splitmouse = 0;
+    self->poolstart = 0;
+    self->count = 0;
+    self->itemsize = 0;
+    fgTypeahead_Init(&self->typeahead);
     return FG_ACCEPT;
   case FG_MOUSEDOWN:
     fgUpdateMouseState(&self->mouse, msg);
@@ -160,27 +835,116 @@ size_t fgList_Message(fgList* self, const FG_Msg* msg)
       fgElement* target = fgElement_GetChildUnderMouse(*self, msg->x, msg->y, &cache);
       if(!target)
         break;
-      size_t index = ((fgElementArray&)self->selected).Find(target);
-      if((self->box->flags&FGLIST_MULTISELECT) != FGLIST_MULTISELECT || !fgroot_instance->GetKey(FG_KEY_SHIFT))
+      size_t index = fgList_IndexOf(self, target);
+      if(index == (size_t)~0)
+        break;
+      bool multi = (self->box->flags&FGLIST_MULTISELECT) == FGLIST_MULTISELECT;
+      if(multi && fgroot_instance->GetKey(FG_KEY_SHIFT)) // Shift selects everything between the anchor and the target
       {
-        for(size_t i = 0; i < self->selected.l; ++i)
-          if(self->selected.p[i]->GetClassName() == FGSTR_LISTITEM)
-            fgStandardNeutralSetStyle(self->selected.p[i], "selected", FGSETSTYLE_REMOVEFLAG);
-        ((fgElementArray&)self->selected).Clear();
+        if(!fgroot_instance->GetKey(FG_KEY_CONTROL))
+          self->selection.l = 0; // SelectRange applies the change, so the selection is only restyled once
+        fgList_SelectRange(self, bssmin(self->anchor, index), bssmax(self->anchor, index) + 1, 1);
       }
-      else if(index != (size_t)-1)
+      else if(multi && fgroot_instance->GetKey(FG_KEY_CONTROL)) // Control toggles the target
       {
-        if(self->selected.p[index]->GetClassName() == FGSTR_LISTITEM)
-          fgStandardNeutralSetStyle(self->selected.p[index], "selected", FGSETSTYLE_REMOVEFLAG);
-        ((fgElementArray&)self->selected).Remove(index);
+        fgList_InvertRange(self, index, index + 1);
+        self->anchor = index;
       }
-
-      if(index == (size_t)-1)
+      else
+      {
+        self->selection.l = 0;
+        fgList_SelectRange(self, index, index + 1, 1);
+        self->anchor = index;
+      }
+    }
+    break;
+  case FG_KEYDOWN:
+    if(msg->keycode == FG_KEY_A && msg->IsCtrlDown() && (self->box->flags&FGLIST_MULTISELECT) == FGLIST_MULTISELECT)
+    {
+      fgList_SelectRange(self, 0, fgList_Count(self), 1);
+      return FG_ACCEPT;
+    }
+    break;
+  case FG_ADDCHILD: // Keep the selection on the same items when items are inserted or removed in the middle of the list
+    if(msg->e != 0 && !msg->e->parent) // Otherwise this gets sent again once the element has left its old parent
+      fgTypeahead_Add(&self->typeahead, msg->e);
+    if(self->selection.l > 0 && !self->source.count && msg->e != 0 && !(msg->e->flags&FGELEMENT_BACKGROUND))
+    {
+      size_t r = fgBox_Message(&self->box, msg);
+      if(r == FG_ACCEPT)
+      {
+        size_t index = fgList_IndexOf(self, msg->e);
+        if(index != (size_t)~0)
+          fgList_ShiftSelection(self, index, true);
+      }
+      fgList_ApplySelection(self);
+      return r;
+    }
+    if(!self->source.count && !self->box.order.batch && msg->e != 0 && !(msg->e->flags&FGELEMENT_BACKGROUND)) // Items that were pushed into view might have a stale style
+    {
+      size_t r = fgBox_Message(&self->box, msg);
+      fgList_ApplySelection(self);
+      return r;
+    }
+    break;
+  case FG_REMOVECHILD:
+    if(msg->e != 0 && msg->e->parent == *self)
+      fgTypeahead_Remove(&self->typeahead, msg->e);
+    if(self->styled > 0 && msg->e != 0 && msg->e->parent == *self && fgList_IsStyled(msg->e))
+      --self->styled;
+    if(self->selection.l > 0 && !self->source.count && msg->e != 0 && msg->e->parent == *self && !(msg->e->flags&FGELEMENT_BACKGROUND))
+    {
+      size_t index = fgList_IndexOf(self, msg->e);
+      if(index != (size_t)~0)
+        fgList_ShiftSelection(self, index, false);
+    }
+    if(!self->source.count && !self->box.order.batch && msg->e != 0 && !(msg->e->flags&FGELEMENT_BACKGROUND))
+    {
+      size_t r = fgBox_Message(&self->box, msg);
+      fgList_ApplySelection(self);
+      return r;
+    }
+    break;
+  case FG_LAYOUTCHANGE:
+    if(msg->subtype == FGELEMENT_LAYOUTREORDER) // Items with the same text have to stay in child order
+      self->typeahead.dirty = 1;
+    if(msg->subtype == FGELEMENT_LAYOUTRESET && !self->source.count && !self->box.order.batch) // This is also how a batch of added or removed items ends
+    {
+      size_t r = fgBox_Message(&self->box, msg);
+      fgList_ApplySelection(self);
+      return r;
+    }
+    break;
+  case FG_KEYCHAR: // Jump to the first item whose text starts with what the user typed
+    if(!self->source.count)
+    {
+      fgElement* item = fgTypeahead_Search(&self->typeahead, &self->box, msg->keychar);
+      if(!item)
+        break;
+      size_t index = fgList_IndexOf(self, item);
+      if((self->box->flags&FGLIST_SELECT) && index != (size_t)~0)
       {
-        if(target->GetClassName() == FGSTR_LISTITEM)
-          fgStandardNeutralSetStyle(target, "selected", FGSETSTYLE_SETFLAG);
-        ((fgElementArray&)self->selected).Insert(target);
+        self->selection.l = 0;
+        fgList_SelectRange(self, index, index + 1, 1);
+        self->anchor = index;
       }
+      AbsRect r;
+      ResolveRect(item, &r);
+      _sendsubmsg<FG_ACTION, void*>(*self, FGSCROLLBAR_SCROLLTOABS, &r);
+      return FG_ACCEPT;
+    }
+    break;
+  case FG_ADDITEM:
+    if(msg->subtype == FGITEM_TEXT && !self->source.count)
+      return (size_t)fgList_AddTextItem(self, (const char*)msg->p, (FGTEXTFMT)msg->u2);
+    if(msg->subtype == FGITEM_TEXTARRAY && !self->source.count) // Wrap each string in a list item, then do a single layout pass at the end
+    {
+      const char** items = (const char**)msg->p;
+      fgBoxOrderedElement_BeginBatch(&self->box.order, msg->u2);
+      for(size_t i = 0; i < msg->u2; ++i)
+        fgList_AddTextItem(self, items[i], FGTEXTFMT_UTF8);
+      fgBoxOrderedElement_EndBatch(&self->box.order, *self);
+      return msg->u2;
     }
     break;
   case FG_MOUSEUP:
@@ -281,8 +1045,73 @@ size_t fgList_Message(fgList* self, const FG_Msg* msg)
     if(msg->subtype == FGVALUE_INT64)
       return (size_t)self->splitter;
     return 0;
-  case FG_GETSELECTEDITEM:
-    return (msg->u) < self->selected.l ? (size_t)self->selected.p[msg->u] : 0;
+  case FG_GETSELECTEDITEM: // Walk the ranges to find the nth selected index. In a virtualized list, this is NULL if the item isn't visible.
+  {
+    size_t n = msg->u;
+    for(size_t i = 0; i < self->selection.l; ++i)
+    {
+      size_t len = self->selection.p[i].end - self->selection.p[i].start;
+      if(n < len)
+        return (size_t)fgList_ItemAt(self, self->selection.p[i].start + n);
+      n -= len;
+    }
+    return 0;
+  }
+  case FG_ACTION: // Any scrollbar action can change what's visible
+  case FG_MOVE:
+  case FG_SETDIM:
+  case FG_SETFLAG:
+  case FG_SETFLAGS:
+    {
+      size_t r = fgBox_Message(&self->box, msg);
+      if(self->source.count != 0)
+        fgList_Realize(self, msg->type == FG_SETFLAG || msg->type == FG_SETFLAGS);
+      else if(msg->type != FG_MOVE || !(msg->u2 & FGMOVE_PROPAGATE)) // A child moving doesn't scroll anything into view
+        fgList_ApplySelection(self);
+      return r;
+    }
+  case FG_LAYOUTFUNCTION: // A virtualized list's size is calculated arithmetically, and its elements are placed explicitly.
+    if(self->source.count != 0)
+    {
+      if(msg->p2 != 0)
+      {
+        AbsVec* dim = (AbsVec*)msg->p2;
+        FABS size = (self->itemsize > 0) ? self->count*self->itemsize : 0;
+        dim->x = fgList_Horizontal(self) ? size : 0;
+        dim->y = fgList_Horizontal(self) ? 0 : size;
+      }
+      return 0;
+    }
+    break;
+  case FG_DRAW: // Elements aren't kept in order as they are recycled, but there are so few of them it doesn't matter.
+    if(self->source.count != 0)
+    {
+      fgStandardDraw(*self, (AbsRect*)msg->p, (fgDrawAuxData*)msg->p2, msg->subtype & 1);
+      return FG_ACCEPT;
+    }
+    break;
+  case FG_INJECT:
+    if(self->source.count != 0)
+      return fgStandardInject(*self, (const FG_Msg*)msg->p, (const AbsRect*)msg->p2);
+    break;
+  case FG_GETITEM:
+    if(self->source.count != 0)
+    {
+      if(msg->subtype == FGITEM_COUNT)
+        return self->count;
+      size_t index = msg->u;
+      if(msg->subtype == FGITEM_LOCATION)
+      {
+        if(self->itemsize <= 0)
+          return 0;
+        AbsRect r;
+        ResolveInnerRect(*self, &r);
+        FABS pos = fgList_Horizontal(self) ? (msg->x - r.left) : (msg->y - r.top);
+        index = (pos < 0) ? 0 : (size_t)(pos / self->itemsize);
+      }
+      return (index >= self->poolstart && index - self->poolstart < self->pool.l) ? (size_t)self->pool.p[index - self->poolstart] : 0;
+    }
+    break;
   case FG_GETCLASSNAME:
     return (size_t)"List";
   }
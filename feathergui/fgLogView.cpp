@@ -0,0 +1,556 @@
+// Copyright 2017 Black Sphere Studios
+// For conditions of distribution and use, see copyright notice in "feathergui.h"
+
+#include "fgLogView.h"
+#include "feathercpp.h"
+#include <float.h>
+
+void fgLogView_Init(fgLogView* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units)
+{
+  fgElement_InternalSetup(*self, parent, next, name, flags, transform, units, (fgDestroy)&fgLogView_Destroy, (fgMessage)&fgLogView_Message);
+}
+
+inline void fgLogView_FreeChunk(fgLogChunk* chunk)
+{
+  ((bss_util::cDynArray<char>*)&chunk->text)->~cDynArray();
+  fgfree(chunk, __FILE__, __LINE__);
+}
+
+void fgLogView_ClearLayouts(fgLogView* self)
+{
+  for(size_t i = 0; i < self->layouts.l; ++i)
+    if(self->layouts.p[i] != 0)
+      fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, self->layouts.p[i]);
+  self->layouts.l = 0;
+}
+
+void fgLogView_Destroy(fgLogView* self)
+{
+  fgLogView_ClearLayouts(self);
+  for(size_t i = 0; i < self->chunks.l; ++i)
+    fgLogView_FreeChunk(self->chunks.p[i]);
+  if(self->spare != 0)
+    fgLogView_FreeChunk(self->spare);
+  if(self->layouts.p != 0)
+    fgfree(self->layouts.p, __FILE__, __LINE__);
+  ((bss_util::cDynArray<fgLogChunk*>*)&self->chunks)->~cDynArray();
+  ((bss_util::cDynArray<float>*)&self->heights)->~cDynArray();
+  if(self->font != 0) fgroot_instance->backend.fgDestroyFont(self->font);
+
+  self->scroll->message = (fgMessage)fgScrollbar_Message;
+  fgScrollbar_Destroy(&self->scroll);
+}
+
+inline size_t fgLogView_UnitSize()
+{
+  switch(fgroot_instance->backend.BackendTextFormat)
+  {
+  case FGTEXTFMT_UTF16: return sizeof(wchar_t);
+  case FGTEXTFMT_UTF32: return sizeof(int);
+  default: break;
+  }
+  return sizeof(char);
+}
+
+inline bool fgLogView_Wraps(fgLogView* self) { return (self->scroll->flags&(FGTEXT_CHARWRAP | FGTEXT_WORDWRAP)) != 0; }
+
+// Lines that don't wrap are always one lineheight tall, so we only have to ask the font when wrapping is enabled.
+float fgLogView_MeasureLine(fgLogView* self, const void* text, size_t len)
+{
+  if(!self->font || !fgLogView_Wraps(self))
+    return self->lineheight;
+  AbsRect area = { 0, 0, self->width, -1.0f };
+  void* layout = fgroot_instance->backend.fgFontLayout(self->font, text, len, self->lineheight, self->letterspacing, &area, self->scroll->flags, 0);
+  if(layout != 0)
+    fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, layout);
+  return bssmax(area.bottom - area.top, self->lineheight);
+}
+
+// Called when the font, lineheight, flags or wrapping width change. Instead of measuring every line, each chunk is estimated to be one lineheight per
+// line, which is exact if nothing wraps, and only gets measured once something looks at it.
+void fgLogView_Remeasure(fgLogView* self)
+{
+  fgLogView_ClearLayouts(self);
+  ++self->version;
+  for(size_t i = 0; i < self->chunks.l; ++i)
+    self->heights.p[i + 1] = self->heights.p[i] + self->chunks.p[i]->count*self->lineheight;
+}
+
+// Measures every line in chunk c if its heights are stale, then shifts every chunk after it by however much the estimate was off.
+void fgLogView_MeasureChunk(fgLogView* self, size_t c)
+{
+  fgLogChunk* chunk = self->chunks.p[c];
+  if(chunk->version == self->version)
+    return;
+  size_t unit = fgLogView_UnitSize();
+  for(size_t j = 0; j < chunk->count; ++j)
+    chunk->y[j + 1] = chunk->y[j] + fgLogView_MeasureLine(self, chunk->text.p + chunk->offsets[j], (chunk->offsets[j + 1] - chunk->offsets[j]) / unit);
+  chunk->version = self->version;
+  float diff = chunk->y[chunk->count] - (self->heights.p[c + 1] - self->heights.p[c]);
+  if(diff != 0.0f)
+    for(size_t i = c + 1; i < self->heights.l; ++i)
+      self->heights.p[i] += diff;
+}
+
+inline fgLogChunk* fgLogView_GetLine(fgLogView* self, size_t index, size_t& line)
+{
+  size_t i = self->first + index; // Every chunk before the last one is full, so this is just a division.
+  line = i % FGLOGVIEW_CHUNKLINES;
+  fgLogView_MeasureChunk(self, i / FGLOGVIEW_CHUNKLINES);
+  return self->chunks.p[i / FGLOGVIEW_CHUNKLINES];
+}
+
+inline float fgLogView_SkipHeight(fgLogView* self)
+{
+  if(!self->chunks.l)
+    return 0.0f;
+  fgLogView_MeasureChunk(self, 0);
+  return self->chunks.p[0]->y[self->first];
+}
+inline float fgLogView_TotalHeight(fgLogView* self) { return self->heights.p[self->heights.l - 1] - fgLogView_SkipHeight(self); }
+
+inline float fgLogView_LineY(fgLogView* self, size_t index)
+{
+  size_t line;
+  size_t i = (self->first + index) / FGLOGVIEW_CHUNKLINES;
+  fgLogChunk* chunk = fgLogView_GetLine(self, index, line);
+  return self->heights.p[i] + chunk->y[line] - fgLogView_SkipHeight(self);
+}
+
+// Finds the line at the given y offset by binary searching the chunk heights, then the line offsets inside that chunk.
+size_t fgLogView_FindLine(fgLogView* self, float y)
+{
+  if(!self->count)
+    return 0;
+  y += fgLogView_SkipHeight(self);
+  ptrdiff_t c = (ptrdiff_t)bss_util::binsearch_before<float, size_t, &bss_util::CompT<float>>(self->heights.p, self->chunks.l, y);
+  c = bssclamp(c, 0, (ptrdiff_t)self->chunks.l - 1);
+  fgLogView_MeasureChunk(self, c); // This only moves the chunks after c, so c is still the right chunk
+  fgLogChunk* chunk = self->chunks.p[c];
+  ptrdiff_t l = (ptrdiff_t)bss_util::binsearch_before<float, size_t, &bss_util::CompT<float>>(chunk->y, chunk->count, y - self->heights.p[c]);
+  l = bssclamp(l, 0, (ptrdiff_t)chunk->count - 1);
+  size_t i = c*FGLOGVIEW_CHUNKLINES + l;
+  return (i < self->first) ? 0 : bssmin(i - self->first, self->count - 1);
+}
+
+void fgLogView_AddLine(fgLogView* self, const void* text, size_t len)
+{
+  fgLogChunk* chunk = !self->chunks.l ? 0 : self->chunks.p[self->chunks.l - 1];
+  if(!chunk || chunk->count >= FGLOGVIEW_CHUNKLINES)
+  {
+    chunk = self->spare;
+    self->spare = 0;
+    if(!chunk)
+    {
+      chunk = fgmalloc<fgLogChunk>(1, __FILE__, __LINE__);
+      memset(&chunk->text, 0, sizeof(fgVectorUTF8));
+    }
+    chunk->text.l = 0;
+    chunk->count = 0;
+    chunk->version = self->version;
+    chunk->offsets[0] = 0;
+    chunk->y[0] = 0;
+    ((bss_util::cDynArray<fgLogChunk*>*)&self->chunks)->Add(chunk);
+    ((bss_util::cDynArray<float>*)&self->heights)->Add(self->heights.p[self->heights.l - 1]);
+  }
+
+  size_t bytes = len*fgLogView_UnitSize();
+  if(chunk->text.l + bytes > chunk->text.s)
+    ((bss_util::cDynArray<char>*)&chunk->text)->Reserve(bssmax(chunk->text.l + bytes, chunk->text.s * 2));
+  if(bytes > 0)
+    memcpy(chunk->text.p + chunk->text.l, text, bytes);
+  chunk->text.l += bytes;
+
+  float height = fgLogView_MeasureLine(self, text, len);
+  chunk->offsets[chunk->count + 1] = chunk->text.l;
+  chunk->y[chunk->count + 1] = chunk->y[chunk->count] + height;
+  ++chunk->count;
+  self->heights.p[self->heights.l - 1] += height;
+  ++self->count;
+}
+
+inline size_t fgLogView_Convert(int from, const void* src, size_t len, void* dest, size_t destlen)
+{
+  switch(fgroot_instance->backend.BackendTextFormat)
+  {
+  case FGTEXTFMT_UTF8:
+    if(from == FGTEXTFMT_UTF16) return fgUTF16toUTF8((const wchar_t*)src, len, (char*)dest, destlen);
+    if(from == FGTEXTFMT_UTF32) return fgUTF32toUTF8((const int*)src, len, (char*)dest, destlen);
+    break;
+  case FGTEXTFMT_UTF16:
+    if(from == FGTEXTFMT_UTF8) return fgUTF8toUTF16((const char*)src, len, (wchar_t*)dest, destlen);
+    if(from == FGTEXTFMT_UTF32) return fgUTF32toUTF16((const int*)src, len, (wchar_t*)dest, destlen);
+    break;
+  case FGTEXTFMT_UTF32:
+    if(from == FGTEXTFMT_UTF8) return fgUTF8toUTF32((const char*)src, len, (int*)dest, destlen);
+    if(from == FGTEXTFMT_UTF16) return fgUTF16toUTF32((const wchar_t*)src, len, (int*)dest, destlen);
+    break;
+  default:
+    break;
+  }
+  return 0;
+}
+
+template<class T>
+void fgLogView_AppendLines(fgLogView* self, const T* text, size_t len, int format)
+{
+  static bss_util::cDynArray<char> buf;
+  if(!text || !len)
+    return;
+  size_t unit = fgLogView_UnitSize();
+  size_t start = 0;
+  for(size_t i = 0; i <= len; ++i)
+  {
+    if(i < len && text[i] != '\n')
+      continue;
+    if(i == len && start == len) // Don't add an empty line for a trailing newline
+      break;
+    size_t end = (i > start && text[i - 1] == '\r') ? i - 1 : i;
+    if(format == fgroot_instance->backend.BackendTextFormat)
+      fgLogView_AddLine(self, text + start, end - start);
+    else
+    {
+      buf.Reserve((fgLogView_Convert(format, text + start, end - start, 0, 0) + 1)*unit);
+      size_t n = (end > start) ? fgLogView_Convert(format, text + start, end - start, (char*)buf, buf.Capacity() / unit) : 0;
+      fgLogView_AddLine(self, (char*)buf, n);
+    }
+    start = i + 1;
+  }
+}
+
+// Drops the oldest lines if we're over maxlines. Chunks are only released once every line in them has been dropped.
+void fgLogView_Trim(fgLogView* self)
+{
+  if(!self->maxlines || self->count <= self->maxlines)
+    return;
+  size_t drop = self->count - self->maxlines;
+  self->first += drop;
+  self->count -= drop;
+  self->dropped += drop;
+
+  size_t n = 0;
+  while(n < self->chunks.l && self->first >= self->chunks.p[n]->count)
+    self->first -= self->chunks.p[n++]->count;
+  if(!n)
+    return;
+
+  for(size_t i = 0; i < n; ++i)
+  {
+    if(!self->spare)
+      self->spare = self->chunks.p[i];
+    else
+      fgLogView_FreeChunk(self->chunks.p[i]);
+  }
+  float base = self->heights.p[n];
+  memmove(self->chunks.p, self->chunks.p + n, (self->chunks.l - n) * sizeof(fgLogChunk*));
+  self->chunks.l -= n;
+  memmove(self->heights.p, self->heights.p + n, (self->heights.l - n) * sizeof(float));
+  self->heights.l -= n;
+  for(size_t i = 0; i < self->heights.l; ++i)
+    self->heights.p[i] -= base;
+}
+
+// Measures any stale chunks that are currently in view, so the heights they are drawn with are exact. Returns true if the total height changed.
+bool fgLogView_MeasureVisible(fgLogView* self)
+{
+  if(!self->count)
+    return false;
+  float height = fgLogView_TotalHeight(self);
+  AbsRect r;
+  ResolveRect(*self, &r);
+  float top = self->scroll.realpadding.top - self->scroll->padding.top;
+  float bottom = top + (r.bottom - r.top) - self->scroll.realpadding.top - self->scroll.realpadding.bottom;
+  size_t start = (self->first + fgLogView_FindLine(self, top)) / FGLOGVIEW_CHUNKLINES;
+  size_t end = (self->first + fgLogView_FindLine(self, bottom)) / FGLOGVIEW_CHUNKLINES;
+  for(size_t i = start; i <= end; ++i)
+    fgLogView_MeasureChunk(self, i);
+  return height != fgLogView_TotalHeight(self);
+}
+
+inline bool fgLogView_AtBottom(fgLogView* self)
+{
+  AbsRect r;
+  ResolveRect(*self, &r);
+  float minpadding = (r.bottom - r.top - self->scroll.realpadding.bottom) - self->scroll.realsize.y - bssmax(self->scroll.barcache.x, 0);
+  return self->scroll->padding.top <= bssmin(minpadding, self->scroll.realpadding.top) + 0.5f;
+}
+
+void fgLogView_AppendText(fgLogView* self, const void* text, size_t len, int format)
+{
+  bool tail = fgLogView_AtBottom(self);
+  switch(format)
+  {
+  case FGTEXTFMT_UTF8: fgLogView_AppendLines<char>(self, (const char*)text, len, format); break;
+  case FGTEXTFMT_UTF16: fgLogView_AppendLines<wchar_t>(self, (const wchar_t*)text, len, format); break;
+  case FGTEXTFMT_UTF32: fgLogView_AppendLines<int>(self, (const int*)text, len, format); break;
+  }
+  float height = fgLogView_TotalHeight(self);
+  fgLogView_Trim(self);
+  height -= fgLogView_TotalHeight(self);
+
+  if(!(self->scroll->flags&FGELEMENT_SILENT))
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+  if(tail) // If we were scrolled to the bottom, stay there. Otherwise, compensate for any lines we dropped so the view doesn't move.
+    _sendsubmsg<FG_ACTION, float, float>(*self, FGSCROLLBAR_CHANGE, 0.0f, -FLT_MAX);
+  else if(height > 0)
+    _sendsubmsg<FG_ACTION, float, float>(*self, FGSCROLLBAR_CHANGE, 0.0f, height);
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+void fgLogView_Append(fgLogView* self, const char* text, size_t len)
+{
+  fgLogView_AppendText(self, text, !len ? strlen(text) : len, FGTEXTFMT_UTF8);
+}
+
+void fgLogView_Clear(fgLogView* self)
+{
+  fgLogView_ClearLayouts(self);
+  for(size_t i = 0; i < self->chunks.l; ++i)
+    fgLogView_FreeChunk(self->chunks.p[i]);
+  self->chunks.l = 0;
+  self->heights.l = 1;
+  self->dropped += self->count;
+  self->first = 0;
+  self->count = 0;
+  self->maxwidth = 0;
+  if(!(self->scroll->flags&FGELEMENT_SILENT))
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+// Makes sure exactly the lines in [start, end) have a cached layout, reusing any that were already visible.
+void fgLogView_UpdateLayouts(fgLogView* self, size_t start, size_t end)
+{
+  size_t a = self->dropped + start;
+  size_t b = self->dropped + end;
+  size_t olda = self->layoutstart;
+  size_t oldb = olda + self->layouts.l;
+  if(a == olda && b == oldb)
+    return;
+
+  void** layouts = fgmalloc<void*>(b - a, __FILE__, __LINE__);
+  for(size_t i = a; i < b; ++i)
+  {
+    layouts[i - a] = 0;
+    if(i >= olda && i < oldb)
+    {
+      layouts[i - a] = self->layouts.p[i - olda];
+      self->layouts.p[i - olda] = 0;
+    }
+  }
+  fgLogView_ClearLayouts(self); // Destroys anything that scrolled out of view
+  if(self->layouts.p != 0)
+    fgfree(self->layouts.p, __FILE__, __LINE__);
+  self->layouts.p = layouts;
+  self->layouts.s = self->layouts.l = b - a;
+  self->layoutstart = a;
+
+  size_t unit = fgLogView_UnitSize();
+  for(size_t i = start; i < end; ++i)
+  {
+    if(layouts[i - start] != 0)
+      continue;
+    size_t line;
+    fgLogChunk* chunk = fgLogView_GetLine(self, i, line);
+    AbsRect area = { 0, 0, fgLogView_Wraps(self) ? self->width : -1.0f, -1.0f };
+    layouts[i - start] = fgroot_instance->backend.fgFontLayout(self->font, chunk->text.p + chunk->offsets[line], (chunk->offsets[line + 1] - chunk->offsets[line]) / unit, self->lineheight, self->letterspacing, &area, self->scroll->flags, 0);
+    self->maxwidth = bssmax(self->maxwidth, area.right - area.left); // This is picked up by the next layout pass
+  }
+}
+
+size_t fgLogView_Message(fgLogView* self, const FG_Msg* msg)
+{
+  static const size_t LAYOUT_MARGIN = 8; // Number of lines above and below the visible area that are also kept laid out
+  assert(self != 0 && msg != 0);
+
+  switch(msg->type)
+  {
+  case FG_CONSTRUCT:
+    memset(&self->chunks, 0, sizeof(self->chunks));
+    memset(&self->heights, 0, sizeof(self->heights));
+    memset(&self->layouts, 0, sizeof(self->layouts));
+    ((bss_util::cDynArray<float>*)&self->heights)->Add(0.0f);
+    self->spare = 0;
+    self->first = 0;
+    self->count = 0;
+    self->dropped = 0;
+    self->maxlines = 0;
+    self->layoutstart = 0;
+    self->width = 0;
+    self->maxwidth = 0;
+    self->version = 0;
+    self->font = 0;
+    self->color.color = 0;
+    self->lineheight = 0; // lineheight must be zero'd before a potential transform unit resolution.
+    self->letterspacing = 0;
+    fgScrollbar_Message(&self->scroll, msg);
+    return FG_ACCEPT;
+  case FG_ADDITEM:
+    if(msg->subtype > FGITEM_TEXT || !msg->p)
+      return 0;
+    fgLogView_Append(self, (const char*)msg->p, msg->u2);
+    return FG_ACCEPT;
+  case FG_GETITEM:
+    if(msg->subtype == FGITEM_COUNT)
+      return self->count;
+    return 0;
+  case FG_SETTEXT:
+    if(msg->subtype > FGTEXTFMT_UTF32)
+      return 0;
+    fgLogView_Clear(self);
+    if(msg->p)
+    {
+      size_t len = msg->u2;
+      switch(msg->subtype)
+      {
+      case FGTEXTFMT_UTF8: if(!len) len = strlen((const char*)msg->p); break;
+      case FGTEXTFMT_UTF16: if(!len) len = wcslen((const wchar_t*)msg->p); break;
+      case FGTEXTFMT_UTF32: if(!len) while(((const int*)msg->p)[len] != 0) ++len; break;
+      }
+      fgLogView_AppendText(self, msg->p, len, msg->subtype);
+    }
+    return FG_ACCEPT;
+  case FG_SETRANGE:
+    self->maxlines = msg->u;
+    fgLogView_AppendText(self, 0, 0, FGTEXTFMT_UTF8); // Appending nothing still trims the log and updates the layout
+    return FG_ACCEPT;
+  case FG_GETRANGE:
+    return self->maxlines;
+  case FG_SETFONT:
+  {
+    fgLogView_ClearLayouts(self);
+    void* oldfont = self->font; // We can't delete this up here because it may rely on the same font we're setting.
+    self->font = 0;
+    if(msg->p)
+    {
+      fgFontDesc desc;
+      fgroot_instance->backend.fgFontGet(msg->p, &desc);
+      fgIntVec dpi = self->scroll->GetDPI();
+      bool identical = (dpi.x == desc.dpi.x && dpi.y == desc.dpi.y);
+      desc.dpi = dpi;
+      self->font = fgroot_instance->backend.fgCloneFont(msg->p, identical ? 0 : &desc);
+    }
+    if(oldfont) fgroot_instance->backend.fgDestroyFont(oldfont);
+    self->maxwidth = 0;
+    fgLogView_Remeasure(self);
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+    fgroot_instance->backend.fgDirtyElement(*self);
+  }
+    return FG_ACCEPT;
+  case FG_SETLINEHEIGHT:
+  case FG_SETLETTERSPACING:
+    if(msg->type == FG_SETLINEHEIGHT)
+      self->lineheight = msg->f;
+    else
+      self->letterspacing = msg->f;
+    fgLogView_Remeasure(self);
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+    fgroot_instance->backend.fgDirtyElement(*self);
+    return FG_ACCEPT;
+  case FG_SETCOLOR:
+    self->color.color = (unsigned int)msg->i;
+    fgroot_instance->backend.fgDirtyElement(*self);
+    return FG_ACCEPT;
+  case FG_GETFONT:
+    return reinterpret_cast<size_t>(self->font);
+  case FG_GETLINEHEIGHT:
+    return *reinterpret_cast<size_t*>(&self->lineheight);
+  case FG_GETLETTERSPACING:
+    return *reinterpret_cast<size_t*>(&self->letterspacing);
+  case FG_GETCOLOR:
+    return self->color.color;
+  case FG_SETFLAGS:
+  {
+    fgFlag oldflags = self->scroll->flags;
+    size_t r = fgScrollbar_Message(&self->scroll, msg);
+    if((oldflags ^ self->scroll->flags)&(FGTEXT_CHARWRAP | FGTEXT_WORDWRAP))
+    {
+      fgLogView_Remeasure(self);
+      fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+    }
+    return r;
+  }
+  case FG_LAYOUTFUNCTION:
+    if(msg->p2 != 0)
+    {
+      AbsVec* dim = (AbsVec*)msg->p2;
+      AbsRect r;
+      ResolveInnerRect(*self, &r);
+      fgIntVec dpi = self->scroll->GetDPI();
+      fgScaleRectDPI(&r, dpi.x, dpi.y);
+      if(fgLogView_Wraps(self) && self->width != r.right - r.left)
+      {
+        self->width = r.right - r.left;
+        fgLogView_Remeasure(self);
+      }
+      self->width = r.right - r.left;
+      fgLogView_MeasureVisible(self);
+      dim->x = self->maxwidth;
+      dim->y = fgLogView_TotalHeight(self);
+    }
+    return 0;
+  case FG_ACTION: // Scrolling can bring chunks with estimated heights into view
+  {
+    size_t r = fgScrollbar_Message(&self->scroll, msg);
+    if(fgLogView_MeasureVisible(self) && !(self->scroll->flags&FGELEMENT_SILENT))
+      fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+    return r;
+  }
+  case FG_DRAW:
+    fgScrollbar_Message(&self->scroll, msg); // Render everything else first
+
+    if(self->font != 0 && self->count > 0 && !(msg->subtype & 1))
+    {
+      AbsRect area = *(AbsRect*)msg->p;
+      fgDrawAuxData* data = (fgDrawAuxData*)msg->p2;
+
+      AbsRect cliparea = area;
+      cliparea.left += self->scroll.realpadding.left;
+      cliparea.top += self->scroll.realpadding.top;
+      cliparea.right -= self->scroll.realpadding.right + bssmax(self->scroll.barcache.y, 0);
+      cliparea.bottom -= self->scroll.realpadding.bottom + bssmax(self->scroll.barcache.x, 0);
+      if(!(self->scroll->flags&FGELEMENT_NOCLIP))
+        fgroot_instance->backend.fgPushClipRect(&cliparea, data);
+
+      GetInnerRect(*self, &area, &area);
+      size_t start = fgLogView_FindLine(self, cliparea.top - area.top);
+      size_t end = fgLogView_FindLine(self, cliparea.bottom - area.top) + 1;
+      fgLogView_UpdateLayouts(self, (start > LAYOUT_MARGIN) ? start - LAYOUT_MARGIN : 0, bssmin(end + LAYOUT_MARGIN, self->count));
+
+      size_t unit = fgLogView_UnitSize();
+      for(size_t i = start; i < end; ++i)
+      {
+        size_t line;
+        fgLogChunk* chunk = fgLogView_GetLine(self, i, line);
+        float y = fgLogView_LineY(self, i);
+        AbsRect r = { area.left, area.top + y, bssmax(area.right, area.left + self->maxwidth), area.top + y + chunk->y[line + 1] - chunk->y[line] };
+        fgScaleRectDPI(&r, data->dpi.x, data->dpi.y);
+        fgSnapAbsRect(r, self->scroll->flags);
+        AbsVec center = ResolveVec(&self->scroll.control.element.transform.center, &r);
+        fgroot_instance->backend.fgDrawFont(self->font,
+          chunk->text.p + chunk->offsets[line],
+          (chunk->offsets[line + 1] - chunk->offsets[line]) / unit,
+          self->lineheight,
+          self->letterspacing,
+          self->color.color,
+          &r,
+          self->scroll.control.element.transform.rotation,
+          &center,
+          self->scroll.control.element.flags,
+          data,
+          self->layouts.p[self->dropped + i - self->layoutstart]);
+      }
+
+      if(!(self->scroll->flags&FGELEMENT_NOCLIP))
+        fgroot_instance->backend.fgPopClipRect(data);
+    }
+    return FG_ACCEPT;
+  case FG_SETDPI:
+    (*self)->SetFont(self->font); // By setting the font to itself we'll clone it into the correct DPI
+    break;
+  case FG_GETCLASSNAME:
+    return (size_t)"LogView";
+  }
+
+  return fgScrollbar_Message(&self->scroll, msg);
+}
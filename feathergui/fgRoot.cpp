@@ -17,9 +17,11 @@
 #include "fgTabcontrol.h"
 #include "fgMenu.h"
 #include "fgGrid.h"
+#include "fgLogView.h"
 #include "feathercpp.h"
 #include "bss-util/cTrie.h"
 #include <stdlib.h>
+#include <limits.h>
 #include <sstream>
 
 KHASH_INIT(fgIDMap, const char*, fgElement*, 1, kh_str_hash_func, kh_str_hash_equal);
@@ -30,6 +32,30 @@ KHASH_INIT(fgCursorMap, unsigned int, void*, 1, kh_int_hash_func, kh_int_hash_eq
 
 fgRoot* fgroot_instance = 0;
 
+// Dispatch tables are never freed until shutdown, because elements cache pointers to them.
+static struct fgDispatchMap
+{
+  ~fgDispatchMap() { for(khiter_t i : hash) delete hash.UnsafeValue(i); }
+  bss_util::cHashBase<void*, fgDispatchTable*, true, bss_util::KH_POINTER_HASHFUNC<void* const&>, bss_util::KH_INT_EQUALFUNC<void*>> hash;
+} fgDispatchTables;
+
+static const unsigned short fgControl_DispatchTypes[] = { FG_CONSTRUCT, FG_SETFLAG, FG_SETFLAGS, FG_SETCONTEXTMENU, FG_GETCONTEXTMENU, FG_GETCLASSNAME,
+  FG_MOUSEDOWN, FG_MOUSEDBLCLICK, FG_MOUSEUP, FG_MOUSEON, FG_MOUSEOFF, FG_MOUSEMOVE, FG_MOUSESCROLL, FG_TOUCHBEGIN, FG_TOUCHEND, FG_TOUCHMOVE,
+  FG_KEYUP, FG_KEYDOWN, FG_KEYCHAR, FG_JOYBUTTONDOWN, FG_JOYBUTTONUP, FG_JOYAXIS, FG_GOTFOCUS, FG_LOSTFOCUS };
+static const unsigned short fgControl_HoverDispatchTypes[] = { FG_MOUSEDOWN, FG_MOUSEDBLCLICK, FG_MOUSEUP, FG_MOUSEON, FG_MOUSEOFF, FG_MOUSEMOVE,
+  FG_MOUSESCROLL, FG_TOUCHBEGIN, FG_TOUCHEND, FG_TOUCHMOVE, FG_KEYUP, FG_KEYDOWN, FG_KEYCHAR, FG_JOYBUTTONDOWN, FG_JOYBUTTONUP, FG_JOYAXIS,
+  FG_GOTFOCUS, FG_LOSTFOCUS };
+static const unsigned short fgScrollbar_DispatchTypes[] = { FG_CONSTRUCT, FG_SETPADDING, FG_MOUSESCROLL, FG_LAYOUTCHANGE, FG_GETLINEHEIGHT, FG_ACTION,
+  FG_ADDCHILD, FG_SETDIM, FG_GETCLASSNAME };
+static const unsigned short fgBox_DispatchTypes[] = { FG_CONSTRUCT, FG_DRAW, FG_INJECT, FG_GETCLASSNAME, // fgBoxOrderedElement_Message handles the rest
+  FG_SETFLAG, FG_SETFLAGS, FG_LAYOUTFUNCTION, FG_LAYOUTCHANGE, FG_REMOVECHILD, FG_ADDCHILD, FG_ADDITEM, FG_REMOVEITEM, FG_GETITEM, FG_SETITEM,
+  FG_SETDIM, FG_GETDIM };
+static const unsigned short fgList_DispatchTypes[] = { FG_CONSTRUCT, FG_MOUSEDOWN, FG_KEYDOWN, FG_ADDCHILD, FG_REMOVECHILD, FG_LAYOUTCHANGE, FG_KEYCHAR, FG_ADDITEM,
+  FG_MOUSEUP, FG_MOUSEMOVE, FG_MOUSEOFF, FG_DRAGOVER, FG_DROP, FG_GETCOLOR, FG_SETCOLOR, FG_SETVALUE, FG_GETVALUE, FG_GETSELECTEDITEM, FG_ACTION,
+  FG_MOVE, FG_SETDIM, FG_SETFLAG, FG_SETFLAGS, FG_LAYOUTFUNCTION, FG_DRAW, FG_INJECT, FG_GETITEM, FG_GETCLASSNAME };
+static const unsigned short fgGrid_DispatchTypes[] = { FG_CONSTRUCT, FG_ADDITEM, FG_REMOVEITEM, FG_GETITEM, FG_SETITEM, FG_SETRANGE, FG_SETVALUE,
+  FG_SETCOLOR, FG_GETCLASSNAME, FG_ACTION, FG_MOVE, FG_LAYOUTFUNCTION };
+
 void fgRoot_Init(fgRoot* self, const AbsRect* area, const fgIntVec* dpi, const fgBackend* backend)
 {
   static fgBackend DEFAULT_BACKEND = {
@@ -110,6 +136,14 @@ void fgRoot_Init(fgRoot* self, const AbsRect* area, const fgIntVec* dpi, const f
   fgRegisterControl("grid", (fgInitializer)fgGrid_Init, sizeof(fgGrid));
   fgRegisterControl("gridrow", (fgInitializer)fgGridRow_Init, sizeof(fgGridRow));
   fgRegisterControl("debug", (fgInitializer)fgDebug_Init, sizeof(fgDebug));
+  fgRegisterControl("logview", (fgInitializer)fgLogView_Init, sizeof(fgLogView));
+
+  fgRegisterDispatch((fgMessage)&fgControl_Message, (fgMessage)&fgElement_Message, fgControl_DispatchTypes, sizeof(fgControl_DispatchTypes) / sizeof(unsigned short));
+  fgRegisterDispatch((fgMessage)&fgControl_HoverMessage, (fgMessage)&fgControl_Message, fgControl_HoverDispatchTypes, sizeof(fgControl_HoverDispatchTypes) / sizeof(unsigned short));
+  fgRegisterDispatch((fgMessage)&fgScrollbar_Message, (fgMessage)&fgControl_HoverMessage, fgScrollbar_DispatchTypes, sizeof(fgScrollbar_DispatchTypes) / sizeof(unsigned short));
+  fgRegisterDispatch((fgMessage)&fgBox_Message, (fgMessage)&fgScrollbar_Message, fgBox_DispatchTypes, sizeof(fgBox_DispatchTypes) / sizeof(unsigned short));
+  fgRegisterDispatch((fgMessage)&fgList_Message, (fgMessage)&fgBox_Message, fgList_DispatchTypes, sizeof(fgList_DispatchTypes) / sizeof(unsigned short));
+  fgRegisterDispatch((fgMessage)&fgGrid_Message, (fgMessage)&fgList_Message, fgGrid_DispatchTypes, sizeof(fgGrid_DispatchTypes) / sizeof(unsigned short));
 }
 
 void fgRoot_Destroy(fgRoot* self)
@@ -129,6 +163,13 @@ void fgRoot_Destroy(fgRoot* self)
     if(i != kh_end(self->cursormap) && kh_exist(self->cursormap, i))
       fgfree(kh_val(self->cursormap, i), __FILE__, __LINE__);
   kh_destroy_fgCursorMap(self->cursormap);
+  ((bss_util::cDynArray<fgDeferAction*>&)self->updateheap).~cDynArray();
+  ((bss_util::cDynArray<fgTween>&)self->animations).~cDynArray();
+  ((bss_util::cDynArray<FG_Msg>&)self->inputqueue).~cDynArray();
+  for(size_t i = 0; i < self->actionblocks.l; ++i)
+    fgfree(self->actionblocks.p[i], __FILE__, __LINE__);
+  ((bss_util::cDynArray<fgDeferAction*>&)self->actionblocks).~cDynArray();
+  self->actionfree = 0;
 }
 
 void fgRoot_CheckMouseMove(fgRoot* self)
@@ -479,6 +520,34 @@ BSS_FORCEINLINE size_t fgProcessCursor(fgRoot* self, size_t value, unsigned shor
   return value;
 }
 
+void fgRoot_QueueInject(fgRoot* self, const FG_Msg* msg)
+{
+  assert(self != 0 && msg != 0);
+  FG_Msg* last = !self->inputqueue.l ? 0 : (self->inputqueue.p + self->inputqueue.l - 1);
+  if(last != 0 && last->type == msg->type)
+  {
+    switch(msg->type)
+    {
+    case FG_TOUCHMOVE:
+      if(last->touchindex != msg->touchindex)
+        break;
+    case FG_MOUSEMOVE: // Only the final position matters, and the button state can't change without a MOUSEDOWN or MOUSEUP in between
+      *last = *msg;
+      return;
+    case FG_MOUSESCROLL:
+    {
+      int delta = last->scrolldelta + msg->scrolldelta;
+      int hdelta = last->scrollhdelta + msg->scrollhdelta;
+      *last = *msg;
+      last->scrolldelta = (short)bssclamp(delta, SHRT_MIN, SHRT_MAX);
+      last->scrollhdelta = (short)bssclamp(hdelta, SHRT_MIN, SHRT_MAX);
+      return;
+    }
+    }
+  }
+  ((bss_util::cDynArray<FG_Msg>&)self->inputqueue).Add(*msg);
+}
+
 size_t fgRoot_Inject(fgRoot* self, const FG_Msg* msg)
 {
   assert(self != 0);
@@ -573,12 +642,19 @@ void fgRoot_Update(fgRoot* self, double delta)
 {
   fgDeferAction* cur;
   self->time += delta;
+  for(size_t i = 0; i < self->inputqueue.l; ++i) // Anything queued while we're injecting is still handled this frame
+  {
+    FG_Msg msg = self->inputqueue.p[i]; // Copied because the queue could be reallocated while the message is handled
+    fgRoot_Inject(self, &msg);
+  }
+  self->inputqueue.l = 0;
+  fgAnimation_Update(&self->animations, self->time);
 
-  while((cur = self->updateroot) && (cur->time <= self->time))
+  while(self->updateheap.l > 0 && (cur = self->updateheap.p[0])->time <= self->time)
   {
-    self->updateroot = cur->next;
+    fgRoot_RemoveAction(self, cur); // Remove the action first so it can be safely re-added, either from inside the callback or later on
     if((*cur->action)(cur->arg)) // If this returns true, we deallocate the node
-      fgfree(cur, __FILE__, __LINE__);
+      fgRoot_DeallocAction(self, cur);
   }
 }
 
@@ -609,60 +685,104 @@ fgMonitor* fgRoot_GetMonitor(const fgRoot* self, const AbsRect* rect)
   return last;
 }
 
+static const size_t FGROOT_ACTIONBLOCK = 64;
+
 fgDeferAction* fgRoot_AllocAction(char (*action)(void*), void* arg, double time)
 {
-  fgDeferAction* r = fgmalloc<fgDeferAction>(1, __FILE__, __LINE__);
+  fgRoot* self = fgroot_instance;
+  assert(self != 0);
+  if(!self->actionfree) // Grab a whole block at once and thread it onto the free list
+  {
+    fgDeferAction* block = fgmalloc<fgDeferAction>(FGROOT_ACTIONBLOCK, __FILE__, __LINE__);
+    ((bss_util::cDynArray<fgDeferAction*>&)self->actionblocks).Add(block);
+    for(size_t i = 0; i < FGROOT_ACTIONBLOCK; ++i)
+      block[i].nextfree = (i + 1 < FGROOT_ACTIONBLOCK) ? (block + i + 1) : 0;
+    self->actionfree = block;
+  }
+  fgDeferAction* r = self->actionfree;
+  self->actionfree = r->nextfree;
   r->action = action;
   r->arg = arg;
   r->time = time;
-  r->next = 0; // We do this so its never ambigious if an action is in the list already or not
-  r->prev = 0;
+  r->heapindex = (size_t)-1; // We do this so its never ambigious if an action is in the heap already or not
   return r;
 }
 
 void fgRoot_DeallocAction(fgRoot* self, fgDeferAction* action)
 {
-  if(action->prev != 0 || action == self->updateroot) // If true you are in the list and must be removed
+  if(action->heapindex != (size_t)-1) // If true you are in the heap and must be removed
     fgRoot_RemoveAction(self, action);
-  fgfree(action, __FILE__, __LINE__);
+  action->nextfree = self->actionfree;
+  self->actionfree = action;
 }
 
-void fgRoot_AddAction(fgRoot* self, fgDeferAction* action)
+BSS_FORCEINLINE static void fgRoot_HeapSet(fgRoot* self, size_t i, fgDeferAction* action)
+{
+  self->updateheap.p[i] = action;
+  action->heapindex = i;
+}
+
+static void fgRoot_HeapUp(fgRoot* self, size_t i)
 {
-  fgDeferAction* cur = self->updateroot;
-  fgDeferAction* prev = 0; // Sadly the elegant pointer to pointer method doesn't work for doubly linked lists.
-  assert(action != 0 && !action->prev && action != self->updateroot);
-  while(cur != 0 && cur->time < action->time)
+  fgDeferAction* action = self->updateheap.p[i];
+  while(i > 0)
   {
-    prev = cur;
-    cur = cur->next;
+    size_t parent = (i - 1) / 2;
+    if(self->updateheap.p[parent]->time <= action->time)
+      break;
+    fgRoot_HeapSet(self, i, self->updateheap.p[parent]);
+    i = parent;
   }
-  action->next = cur;
-  action->prev = prev;
-  if(prev) prev->next = action;
-  else self->updateroot = action; // Prev is only null if we're inserting before the root, which means we must reassign the root.
-  if(cur) cur->prev = action; // Cur is null if we are at the end of the list.
+  fgRoot_HeapSet(self, i, action);
+}
+
+static void fgRoot_HeapDown(fgRoot* self, size_t i)
+{
+  fgDeferAction* action = self->updateheap.p[i];
+  size_t child;
+  while((child = (i * 2) + 1) < self->updateheap.l)
+  {
+    if(child + 1 < self->updateheap.l && self->updateheap.p[child + 1]->time < self->updateheap.p[child]->time)
+      ++child;
+    if(action->time <= self->updateheap.p[child]->time)
+      break;
+    fgRoot_HeapSet(self, i, self->updateheap.p[child]);
+    i = child;
+  }
+  fgRoot_HeapSet(self, i, action);
+}
+
+void fgRoot_AddAction(fgRoot* self, fgDeferAction* action)
+{
+  assert(action != 0 && action->heapindex == (size_t)-1);
+  ((bss_util::cDynArray<fgDeferAction*>&)self->updateheap).Add(action);
+  action->heapindex = self->updateheap.l - 1;
+  fgRoot_HeapUp(self, action->heapindex);
 }
 
 void fgRoot_RemoveAction(fgRoot* self, fgDeferAction* action)
 {
-  assert(action != 0 && (action->prev != 0 || action == self->updateroot));
-  if(action->prev != 0) action->prev->next = action->next;
-  else self->updateroot = action->next;
-  if(action->next != 0) action->next->prev = action->prev;
-  action->next = 0; // We do this so its never ambigious if an action is in the list already or not
-  action->prev = 0;
+  assert(action != 0 && action->heapindex < self->updateheap.l && self->updateheap.p[action->heapindex] == action);
+  size_t i = action->heapindex;
+  fgDeferAction* last = self->updateheap.p[--self->updateheap.l];
+  if(i < self->updateheap.l) // Move the last action into the hole, then let it settle in whichever direction it needs to go
+  {
+    fgRoot_HeapSet(self, i, last);
+    fgRoot_HeapUp(self, i);
+    fgRoot_HeapDown(self, last->heapindex);
+  }
+  action->heapindex = (size_t)-1; // We do this so its never ambigious if an action is in the heap already or not
 }
 
 void fgRoot_ModifyAction(fgRoot* self, fgDeferAction* action)
 {
-  if((action->next != 0 && action->next->time < action->time) || (action->prev != 0 && action->prev->time > action->time))
-  {
-    fgRoot_RemoveAction(self, action);
+  if(action->heapindex == (size_t)-1) // If true you aren't in the heap so we need to add you
     fgRoot_AddAction(self, action);
+  else
+  {
+    fgRoot_HeapUp(self, action->heapindex);
+    fgRoot_HeapDown(self, action->heapindex);
   }
-  else if(!action->prev && action != self->updateroot) // If true you aren't in the list so we need to add you
-    fgRoot_AddAction(self, action);
 }
 fgElement* fgRoot_GetID(fgRoot* self, const char* id)
 {
@@ -733,6 +853,69 @@ void fgRegisterControl(const char* name, fgInitializer fn, size_t sz)
   kh_val(fgroot_instance->initmap, i).first = fn;
   kh_val(fgroot_instance->initmap, i).second = sz;
 }
+static fgDispatchTable* fgDispatch_Acquire(fgMessage message)
+{
+  khiter_t i = fgDispatchTables.hash.Iterator((void*)message);
+  if(fgDispatchTables.hash.ExistsIter(i))
+    return fgDispatchTables.hash.UnsafeValue(i);
+
+  fgDispatchTable* table = new fgDispatchTable; // Until it's registered, a message function handles everything itself
+  table->message = message;
+  for(size_t j = 0; j < FG_CUSTOMEVENT; ++j)
+    table->handlers[j] = message;
+  fgDispatchTables.hash.Insert((void*)message, table);
+  return table;
+}
+const fgDispatchTable* fgDispatch_Get(fgMessage message) { return fgDispatch_Acquire(message); }
+
+#ifdef BSS_DEBUG
+// The dispatch type lists are maintained by hand, so if a handler gains a case its list doesn't mention, the table silently skips it. Queries have no
+// side effects, so whenever the table skips a handler for one, we also ask the full handler chain and make sure both answers agree. A mismatch means
+// the skipped handler's type list in fgRoot_Init is missing that type.
+size_t fgDispatch_Verify(fgElement* self, const FG_Msg* msg, fgMessage handler)
+{
+  size_t r = (*handler)(self, msg);
+  switch(msg->type)
+  {
+  case FG_GETSKIN:
+  case FG_GETSTYLE:
+  case FG_GETCLASSNAME:
+  case FG_GETDPI:
+  case FG_GETDIM:
+  case FG_GETSCALING:
+  case FG_GETNAME:
+  case FG_GETCONTEXTMENU:
+  case FG_GETITEM:
+  case FG_GETSELECTEDITEM:
+  case FG_GETVALUE:
+  case FG_GETRANGE:
+  case FG_GETASSET:
+  case FG_GETUV:
+  case FG_GETCOLOR:
+  case FG_GETOUTLINE:
+  case FG_GETFONT:
+  case FG_GETLINEHEIGHT:
+  case FG_GETLETTERSPACING:
+  case FG_GETTEXT:
+    assert(r == (*self->message)(self, msg));
+    break;
+  default:
+    break;
+  }
+  return r;
+}
+#endif
+
+void fgRegisterDispatch(fgMessage message, fgMessage parent, const unsigned short* types, size_t count)
+{
+  fgDispatchTable* table = fgDispatch_Acquire(message); // Filled in place, because elements may already point to it
+  const fgDispatchTable* base = !parent ? 0 : fgDispatch_Acquire(parent);
+  for(size_t i = 0; i < FG_CUSTOMEVENT; ++i)
+    table->handlers[i] = !base ? message : base->handlers[i];
+  for(size_t i = 0; i < count; ++i)
+    if(types[i] < FG_CUSTOMEVENT)
+      table->handlers[types[i]] = message;
+}
 void fgIterateControls(void* p, void(*fn)(void*, const char*))
 {
   for(khiter_t i = 0; i < fgroot_instance->initmap->n_buckets; ++i) // We do have to clear this one, though.
@@ -12,13 +12,21 @@ void fgTextbox_Init(fgTextbox* self, fgElement* BSS_RESTRICT parent, fgElement*
 void fgTextbox_Destroy(fgTextbox* self)
 {
   if(self->layout != 0) fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, self->layout);
+  if(self->linelayout != 0) fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, self->linelayout);
   if(self->font != 0) fgroot_instance->backend.fgDestroyFont(self->font);
   ((bss_util::cDynArray<int>*)&self->text32)->~cDynArray();
   ((bss_util::cDynArray<wchar_t>*)&self->text16)->~cDynArray();
   ((bss_util::cDynArray<char>*)&self->text8)->~cDynArray();
+  ((bss_util::cDynArray<size_t>*)&self->linestarts)->~cDynArray();
+  ((bss_util::cDynArray<char>*)&self->line8)->~cDynArray();
+  ((bss_util::cDynArray<wchar_t>*)&self->line16)->~cDynArray();
   ((bss_util::cDynArray<int>*)&self->placeholder32)->~cDynArray();
   ((bss_util::cDynArray<wchar_t>*)&self->placeholder16)->~cDynArray();
   ((bss_util::cDynArray<char>*)&self->placeholder8)->~cDynArray();
+  ((bss_util::cDynArray<char>*)&self->maskcache)->~cDynArray();
+  ((bss_util::cDynArray<fgTextboxEdit>*)&self->undolog)->~cDynArray();
+  ((bss_util::cDynArray<int>*)&self->undodata)->~cDynArray();
+  ((bss_util::cDynArray<fgTextboxMatch>*)&self->matches)->~cDynArray();
 
   self->scroll->message = (fgMessage)fgScrollbar_Message;
   fgScrollbar_Destroy(&self->scroll);
@@ -30,6 +38,195 @@ inline void fgTextbox_SetCursorEnd(fgTextbox* self)
   self->endpos = self->startpos;
 }
 
+inline void fgTextbox_RebuildLines(fgTextbox* self)
+{
+  bss_util::cDynArray<size_t>& lines = *(bss_util::cDynArray<size_t>*)&self->linestarts;
+  lines.Clear();
+  lines.Add(0);
+  for(size_t i = 0; i < self->text32.l; ++i)
+    if(self->text32.p[i] == '\n')
+      lines.Add(i + 1);
+  self->linelayoutline = (size_t)~0;
+}
+
+// Returns the line that contains the given code-point offset
+inline size_t fgTextbox_GetLine(fgTextbox* self, size_t index)
+{
+  assert(self->linestarts.l > 0);
+  return bss_util::binsearch_before<size_t, size_t, &bss_util::CompT<size_t>>(self->linestarts.p, self->linestarts.l, index);
+}
+
+inline void fgTextbox_InsertLines(fgTextbox* self, size_t start, const int* s, size_t len)
+{
+  size_t line = fgTextbox_GetLine(self, start);
+  size_t k = 0;
+  for(size_t i = 0; i < len; ++i)
+    if(s[i] == '\n') ++k;
+  for(size_t i = line + 1; i < self->linestarts.l; ++i)
+    self->linestarts.p[i] += len;
+  if(!k) return;
+
+  ((bss_util::cDynArray<size_t>*)&self->linestarts)->Reserve(self->linestarts.l + k);
+  size_t* p = self->linestarts.p;
+  memmove(p + line + 1 + k, p + line + 1, (self->linestarts.l - line - 1) * sizeof(size_t));
+  for(size_t i = 0, j = line + 1; i < len; ++i)
+    if(s[i] == '\n')
+      p[j++] = start + i + 1;
+  self->linestarts.l += k;
+}
+
+inline void fgTextbox_RemoveLines(fgTextbox* self, size_t start, size_t end)
+{
+  size_t a = fgTextbox_GetLine(self, start) + 1; // first line that starts inside the removed range
+  size_t b = fgTextbox_GetLine(self, end) + 1; // first line that starts after it
+  size_t* p = self->linestarts.p;
+  memmove(p + a, p + b, (self->linestarts.l - b) * sizeof(size_t));
+  self->linestarts.l -= b - a;
+  for(size_t i = a; i < self->linestarts.l; ++i)
+    p[i] -= end - start;
+}
+
+// Gets a single line of text (without the newline) in the backend format. This is only valid until the next call.
+inline const void* fgTextbox_GetLineText(fgTextbox* self, size_t line, size_t& len)
+{
+  size_t start = self->linestarts.p[line];
+  len = ((line + 1 < self->linestarts.l) ? (self->linestarts.p[line + 1] - 1) : self->text32.l) - start;
+
+  switch(fgroot_instance->backend.BackendTextFormat)
+  {
+  case FGTEXTFMT_UTF8:
+  {
+    bss_util::cDynArray<char>& buf = *(bss_util::cDynArray<char>*)&self->line8;
+    buf.Reserve(fgUTF32toUTF8(self->text32.p + start, len, 0, 0) + 1);
+    len = fgUTF32toUTF8(self->text32.p + start, len, buf, buf.Capacity());
+    return (const char*)buf;
+  }
+  case FGTEXTFMT_UTF16:
+  {
+    bss_util::cDynArray<wchar_t>& buf = *(bss_util::cDynArray<wchar_t>*)&self->line16;
+    buf.Reserve(fgUTF32toUTF16(self->text32.p + start, len, 0, 0) + 1);
+    len = fgUTF32toUTF16(self->text32.p + start, len, buf, buf.Capacity());
+    return (const wchar_t*)buf;
+  }
+  default:
+    return self->text32.p + start;
+  }
+}
+
+// Returns a layout of the given line for the backend to answer caret queries with. It's built the same way the whole text is, so the positions match what gets drawn.
+inline void* fgTextbox_GetLineLayout(fgTextbox* self, size_t line, const void* text, size_t len)
+{
+  if(self->linelayoutline != line || !self->linelayout)
+  {
+    AbsRect area = self->areacache;
+    self->linelayout = fgroot_instance->backend.fgFontLayout(self->font, text, len, self->lineheight, self->letterspacing, &area, self->scroll->flags, self->linelayout);
+    self->linelayoutline = line;
+  }
+  return self->linelayout;
+}
+
+// Multi-line text that doesn't wrap can be queried one line at a time, because every line starts at a multiple of the lineheight.
+inline bool fgTextbox_ByLine(fgTextbox* self)
+{
+  return self->linestarts.l > 1 && self->lineheight > 0 && !(self->scroll->flags&(FGTEXT_CHARWRAP | FGTEXT_WORDWRAP));
+}
+
+// Replaces "remove" code points at start with the given text, without touching the cursor or the undo history.
+inline void fgTextbox_Splice(fgTextbox* self, size_t start, size_t remove, const int* s, size_t len)
+{
+  if(!remove && !len)
+    return;
+  if(remove > 0)
+  {
+    assert(self->text32.p != 0);
+    fgTextbox_RemoveLines(self, start, start + remove);
+    bss_util::RemoveRangeSimple<int>(self->text32.p, self->text32.l, start, remove);
+    self->text32.l -= remove;
+  }
+  if(len > 0)
+  {
+    ((bss_util::cDynArray<int>*)&self->text32)->Reserve(self->text32.l + len + 1);
+    assert(self->text32.p != 0);
+    fgTextbox_InsertLines(self, start, s, len);
+    bss_util::InsertRangeSimple<int>(self->text32.p, self->text32.l, start, s, len);
+    self->text32.l += len;
+  }
+  self->text32.p[self->text32.l] = 0;
+  self->text16.l = 0;
+  self->text8.l = 0;
+  self->matches.l = 0;
+  self->linelayoutline = (size_t)~0;
+  fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+}
+
+inline void fgTextbox_ClearUndo(fgTextbox* self)
+{
+  self->undolog.l = 0;
+  self->undodata.l = 0;
+  self->undoindex = 0;
+}
+
+// Records an edit before it is applied. Single character typing or deletion is coalesced into the previous edit if it continues where that edit left off.
+inline void fgTextbox_RecordEdit(fgTextbox* self, size_t offset, size_t removed, const int* s, size_t len)
+{
+  if(self->mask != 0 || !self->undobudget) // We never keep a history of masked text.
+    return;
+  bss_util::cDynArray<fgTextboxEdit>& log = *(bss_util::cDynArray<fgTextboxEdit>*)&self->undolog;
+  bss_util::cDynArray<int>& data = *(bss_util::cDynArray<int>*)&self->undodata;
+  if(self->undoindex < log.Length()) // A new edit discards anything that could have been redone
+  {
+    data.SetLength(log[self->undoindex].data);
+    log.SetLength(self->undoindex);
+  }
+
+  fgTextboxEdit* last = !log.Length() ? 0 : &log.Back(); // The last edit's data is always at the end of undodata
+  if(last && !removed && len == 1 && s[0] != '\n' && !last->removed && last->offset + last->inserted == offset)
+  {
+    data.Add(s[0]);
+    ++last->inserted;
+  }
+  else if(last && removed == 1 && !len && !last->inserted && offset + 1 == last->offset) // backspace
+  {
+    data.Insert(self->text32.p[offset], last->data);
+    --last->offset;
+    ++last->removed;
+  }
+  else if(last && removed == 1 && !len && !last->inserted && offset == last->offset) // delete
+  {
+    data.Add(self->text32.p[offset]);
+    ++last->removed;
+  }
+  else
+  {
+    fgTextboxEdit e = { offset, removed, len, data.Length() };
+    log.Add(e);
+    data.SetLength(e.data + removed + len);
+    memcpy(data + e.data, self->text32.p + offset, removed * sizeof(int));
+    memcpy(data + e.data + removed, s, len * sizeof(int));
+  }
+  self->undoindex = log.Length();
+
+  // If we're over budget, drop the oldest edits until we're at 3/4 of it, so we don't have to do this on every keystroke.
+  size_t bytes = log.Length()*sizeof(fgTextboxEdit) + data.Length()*sizeof(int);
+  if(bytes <= self->undobudget)
+    return;
+  size_t target = self->undobudget - (self->undobudget >> 2);
+  size_t drop = 0;
+  while(drop < log.Length() && bytes > target)
+  {
+    bytes -= sizeof(fgTextboxEdit) + (log[drop].removed + log[drop].inserted) * sizeof(int);
+    ++drop;
+  }
+  size_t cut = (drop < log.Length()) ? log[drop].data : data.Length();
+  bss_util::RemoveRangeSimple<int>(self->undodata.p, self->undodata.l, (size_t)0, cut);
+  self->undodata.l -= cut;
+  bss_util::RemoveRangeSimple<fgTextboxEdit>(self->undolog.p, self->undolog.l, (size_t)0, drop);
+  self->undolog.l -= drop;
+  for(size_t i = 0; i < self->undolog.l; ++i)
+    self->undolog.p[i].data -= cut;
+  self->undoindex = self->undolog.l;
+}
+
 inline size_t fgTextbox_DeleteSelection(fgTextbox* self)
 {
   if(self->start == self->end)
@@ -41,57 +238,127 @@ inline size_t fgTextbox_DeleteSelection(fgTextbox* self)
     bss_util::rswap(self->startpos, self->endpos);
   }
 
-  bss_util::RemoveRangeSimple<int>(self->text32.p, self->text32.l, self->start, self->end - self->start);
-  self->text32.l -= self->end - self->start;
-  self->text32.p[self->text32.l] = 0;
-  self->text16.l = 0;
-  self->text8.l = 0;
+  size_t end = self->end;
+  fgTextbox_RecordEdit(self, self->start, end - self->start, 0, 0);
   fgTextbox_SetCursorEnd(self);
-  fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
+  fgTextbox_Splice(self, self->start, end - self->start, 0, 0);
   return FG_ACCEPT;
 }
 
-#define FILLMASK(self, text) \
-switch(fgroot_instance->backend.BackendTextFormat)\
-{\
-case FGTEXTFMT_UTF8:\
-  text = ALLOCA((self->text8.l + 1) * sizeof(char));\
-  for(size_t i = 0; i < self->text8.l; ++i) ((char*)text)[i] = self->mask;\
-  ((char*)text)[self->text8.l] = 0;\
-  break;\
-case FGTEXTFMT_UTF16:\
-  text = ALLOCA((self->text16.l + 1) * sizeof(wchar_t));\
-  for(size_t i = 0; i < self->text16.l; ++i) ((wchar_t*)text)[i] = self->mask;\
-  ((wchar_t*)text)[self->text16.l] = 0;\
-  break;\
-case FGTEXTFMT_UTF32:\
-  text = ALLOCA((self->text32.l + 1) * sizeof(int));\
-  for(size_t i = 0; i < self->text32.l; ++i) ((int*)text)[i] = self->mask;\
-  ((int*)text)[self->text32.l] = 0;\
-  break;\
+template<class T>
+inline void fgTextbox_FillMask(fgVector* cache, int mask, size_t len)
+{
+  ((bss_util::cDynArray<T>*)cache)->Reserve(len + 1);
+  T* p = (T*)cache->p;
+  for(size_t i = cache->l; i < len; ++i) p[i] = (T)mask; // Everything below cache->l is already the mask character
+  p[len] = 0;
+  cache->l = len;
 }
 
-inline void fgTextbox_fixpos(fgTextbox* self, size_t cursor, AbsVec* r)
+// Returns the text in the backend format. If we have a mask, this is the cached masked text, which has one mask character per codepoint.
+inline fgVector* fgTextbox_GetDisplayText(fgTextbox* self)
 {
-  fgVector* v = fgText_Conversion(fgroot_instance->backend.BackendTextFormat, &self->text8, &self->text16, &self->text32);
-  if(!v) return;
-  void* text = v->p;
-  if(self->mask)
-    FILLMASK(self, text)
+  if(!self->mask)
+    return fgText_Conversion(fgroot_instance->backend.BackendTextFormat, &self->text8, &self->text16, &self->text32);
+  if(self->maskcache.l != self->text32.l || !self->maskcache.p)
+  {
+    switch(fgroot_instance->backend.BackendTextFormat)
+    {
+    case FGTEXTFMT_UTF8: fgTextbox_FillMask<char>(&self->maskcache, self->mask, self->text32.l); break;
+    case FGTEXTFMT_UTF16: fgTextbox_FillMask<wchar_t>(&self->maskcache, self->mask, self->text32.l); break;
+    case FGTEXTFMT_UTF32: fgTextbox_FillMask<int>(&self->maskcache, self->mask, self->text32.l); break;
+    default: break;
+    }
+  }
+  return &self->maskcache;
+}
+
+// If the mask is laid out on a single line, every character has the same advance, so we only ask the font about it once.
+inline float fgTextbox_MaskAdvance(fgTextbox* self)
+{
+  if(!self->mask || !self->font)
+    return 0;
+  if(self->maskadvance < 0)
+  {
+    self->maskadvance = 0;
+    if(!(self->scroll->flags&(FGTEXT_CHARWRAP | FGTEXT_WORDWRAP | FGTEXT_RTL | FGTEXT_RIGHTALIGN | FGTEXT_CENTER)))
+    {
+      int text[3] = { self->mask, self->mask, 0 };
+      wchar_t text16[3] = { (wchar_t)self->mask, (wchar_t)self->mask, 0 };
+      char text8[3] = { (char)self->mask, (char)self->mask, 0 };
+      void* t = text;
+      switch(fgroot_instance->backend.BackendTextFormat)
+      {
+      case FGTEXTFMT_UTF8: t = text8; break;
+      case FGTEXTFMT_UTF16: t = text16; break;
+      default: break;
+      }
+      AbsRect area = self->areacache; // Build a temporary layout so the backend doesn't have to create one for each query
+      void* layout = fgroot_instance->backend.fgFontLayout(self->font, t, 2, self->lineheight, self->letterspacing, &area, self->scroll->flags, 0);
+      AbsVec a = fgroot_instance->backend.fgFontPos(self->font, t, 2, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, 1, layout);
+      AbsVec b = fgroot_instance->backend.fgFontPos(self->font, t, 2, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, 2, layout);
+      if(layout != 0)
+        fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, layout);
+      if(a.y == b.y && b.x > a.x)
+        self->maskadvance = b.x - a.x;
+    }
+  }
+  return self->maskadvance;
+}
 
-  *r = fgroot_instance->backend.fgFontPos(self->font, text, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, cursor, self->layout);
+inline void fgTextbox_GetPos(fgTextbox* self, size_t cursor, AbsVec* r)
+{
+  float advance = fgTextbox_MaskAdvance(self);
+  if(advance > 0)
+    *r = AbsVec{ bssmin(cursor, self->text32.l)*advance, 0 };
+  else if(!self->mask && fgTextbox_ByLine(self))
+  {
+    size_t line = fgTextbox_GetLine(self, cursor);
+    size_t len;
+    const void* text = fgTextbox_GetLineText(self, line, len);
+    void* layout = fgTextbox_GetLineLayout(self, line, text, len);
+    *r = fgroot_instance->backend.fgFontPos(self->font, text, len, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, cursor - self->linestarts.p[line], layout);
+    r->y += line*self->lineheight;
+  }
+  else
+  {
+    fgVector* v = fgTextbox_GetDisplayText(self);
+    if(!v) return;
+    *r = fgroot_instance->backend.fgFontPos(self->font, v->p, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, cursor, self->layout);
+  }
+}
+inline void fgTextbox_fixpos(fgTextbox* self, size_t cursor, AbsVec* r)
+{
+  fgTextbox_GetPos(self, cursor, r);
   AbsRect to = { r->x, r->y, r->x, r->y + self->lineheight*1.125f }; // We don't know what the descender is, so we estimate it as 1/8 the lineheight.
   _sendsubmsg<FG_ACTION, void*>(*self, FGSCROLLBAR_SCROLLTO, &to);
   self->lastx = self->startpos.x;
 }
 inline size_t fgTextbox_fixindex(fgTextbox* self, AbsVec pos, AbsVec* cursor)
 {
-  fgVector* v = fgText_Conversion(fgroot_instance->backend.BackendTextFormat, &self->text8, &self->text16, &self->text32);
-  if(!v) return 0;
-  void* text = v->p;
-  if(self->mask)
-    FILLMASK(self, text)
-  size_t r = fgroot_instance->backend.fgFontIndex(self->font, text, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, pos, cursor, self->layout);
+  size_t r;
+  float advance = fgTextbox_MaskAdvance(self);
+  if(advance > 0)
+  {
+    r = (pos.x <= 0) ? 0 : bssmin((size_t)roundf(pos.x / advance), self->text32.l);
+    *cursor = AbsVec{ r*advance, 0 };
+  }
+  else if(!self->mask && fgTextbox_ByLine(self))
+  {
+    size_t line = (pos.y <= 0) ? 0 : bssmin((size_t)(pos.y / self->lineheight), self->linestarts.l - 1);
+    size_t len;
+    const void* text = fgTextbox_GetLineText(self, line, len);
+    void* layout = fgTextbox_GetLineLayout(self, line, text, len);
+    pos.y -= line*self->lineheight;
+    r = self->linestarts.p[line] + fgroot_instance->backend.fgFontIndex(self->font, text, len, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, pos, cursor, layout);
+    cursor->y += line*self->lineheight;
+  }
+  else
+  {
+    fgVector* v = fgTextbox_GetDisplayText(self);
+    if(!v) return 0;
+    r = fgroot_instance->backend.fgFontIndex(self->font, v->p, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, pos, cursor, self->layout);
+  }
   AbsRect to = { cursor->x, cursor->y, cursor->x, cursor->y + self->lineheight*1.125f };
   _sendsubmsg<FG_ACTION, void*>(*self, FGSCROLLBAR_SCROLLTO, &to);
   return r;
@@ -99,14 +366,8 @@ inline size_t fgTextbox_fixindex(fgTextbox* self, AbsVec pos, AbsVec* cursor)
 inline void fgTextbox_Insert(fgTextbox* self, size_t start, const int* s, size_t len)
 {
   if(!s[len - 1]) --len; // We cannot insert a null pointer in the middle of our text, so remove it if it exists.
-  ((bss_util::cDynArray<int>*)&self->text32)->Reserve(self->text32.l + len + 1);
-  assert(self->text32.p != 0);
-  bss_util::InsertRangeSimple<int>(self->text32.p, self->text32.l, start, s, len);
-  self->text32.l += len;
-  self->text32.p[self->text32.l] = 0;
-  self->text16.l = 0;
-  self->text8.l = 0;
-  fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE|FGMOVE_RESIZE);
+  fgTextbox_RecordEdit(self, start, 0, s, len);
+  fgTextbox_Splice(self, start, 0, s, len);
   self->start += len;
   fgTextbox_fixpos(self, self->start, &self->startpos);
   fgTextbox_SetCursorEnd(self);
@@ -146,6 +407,193 @@ inline void fgTextbox_MoveCursor(fgTextbox* self, int num, bool select, bool wor
     fgTextbox_SetCursorEnd(self);
 }
 
+inline size_t fgTextbox_Undo(fgTextbox* self)
+{
+  if(!self->undoindex)
+    return 0;
+  fgTextboxEdit& e = self->undolog.p[--self->undoindex];
+  self->start = e.offset + e.removed; // Select the text we restored
+  self->end = e.offset;
+  fgTextbox_Splice(self, e.offset, e.inserted, self->undodata.p + e.data, e.removed);
+  fgTextbox_fixpos(self, self->end, &self->endpos);
+  fgTextbox_fixpos(self, self->start, &self->startpos);
+  return FG_ACCEPT;
+}
+
+inline size_t fgTextbox_Redo(fgTextbox* self)
+{
+  if(self->undoindex >= self->undolog.l)
+    return 0;
+  fgTextboxEdit& e = self->undolog.p[self->undoindex++];
+  self->start = e.offset + e.inserted;
+  fgTextbox_Splice(self, e.offset, e.removed, self->undodata.p + e.data + e.removed, e.inserted);
+  fgTextbox_fixpos(self, self->start, &self->startpos);
+  fgTextbox_SetCursorEnd(self);
+  return FG_ACCEPT;
+}
+
+inline int fgTextbox_FoldASCII(int c) { return (c >= 'A' && c <= 'Z') ? (c + ('a' - 'A')) : c; }
+
+// Returns the next occurrence of find at or after offset, or -1. Four code points at a time are compared against the first code point of find using SSE2, and only those candidates are verified.
+inline size_t fgTextbox_Search(const int* text, size_t len, size_t offset, const int* find, size_t findlen, bool nocase)
+{
+  if(!findlen || findlen > len)
+    return (size_t)~0;
+  size_t last = len - findlen; // last possible starting point of a match
+  int first = find[0];
+  int alt = first;
+  if(nocase && first >= 'a' && first <= 'z') alt = first - ('a' - 'A');
+  if(nocase && first >= 'A' && first <= 'Z') alt = first + ('a' - 'A');
+
+  auto verify = [&](size_t i) -> bool {
+    if(nocase)
+    {
+      for(size_t j = 1; j < findlen; ++j)
+        if(fgTextbox_FoldASCII(text[i + j]) != fgTextbox_FoldASCII(find[j]))
+          return false;
+      return true;
+    }
+    return !memcmp(text + i + 1, find + 1, (findlen - 1) * sizeof(int));
+  };
+
+  size_t i = offset;
+  sseVeci a(first);
+  sseVeci b(alt);
+  for(; i + 4 <= last + 1; i += 4)
+  {
+    sseVeci v(BSS_UNALIGNED<const int>(text + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(((v == a) | (v == b)).xmm));
+    for(int k = 0; mask != 0; ++k, mask >>= 1)
+      if((mask & 1) && verify(i + k))
+        return i + k;
+  }
+  for(; i <= last; ++i)
+    if((text[i] == first || text[i] == alt) && verify(i))
+      return i;
+  return (size_t)~0;
+}
+
+// Finds every non-overlapping match and stores them in self->matches, without calculating their positions.
+inline size_t fgTextbox_FindAll(fgTextbox* self, const int* find, size_t findlen, bool nocase)
+{
+  bss_util::cDynArray<fgTextboxMatch>& matches = *(bss_util::cDynArray<fgTextboxMatch>*)&self->matches;
+  matches.Clear();
+  for(size_t i = fgTextbox_Search(self->text32.p, self->text32.l, 0, find, findlen, nocase); i != (size_t)~0; i = fgTextbox_Search(self->text32.p, self->text32.l, i + findlen, find, findlen, nocase))
+  {
+    fgTextboxMatch m = { i, i + findlen, { 0, 0 }, { 0, 0 } };
+    matches.Add(m);
+  }
+  return matches.Length();
+}
+
+// Every match is queried against the layout of the whole text, so the backend never has to build one per match.
+inline void fgTextbox_FixMatches(fgTextbox* self)
+{
+  if(!self->matches.l)
+    return;
+  fgVector* v = fgTextbox_GetDisplayText(self);
+  if(!v)
+    return;
+  for(size_t i = 0; i < self->matches.l; ++i)
+  {
+    fgTextboxMatch& m = self->matches.p[i];
+    m.startpos = fgroot_instance->backend.fgFontPos(self->font, v->p, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, m.start, self->layout);
+    m.endpos = fgroot_instance->backend.fgFontPos(self->font, v->p, v->l, self->lineheight, self->letterspacing, &self->areacache, self->scroll->flags, m.end, self->layout);
+  }
+}
+
+inline size_t fgTextbox_Find(fgTextbox* self, unsigned short action, const fgTextboxFind* f)
+{
+  if(action == FGTEXTBOX_FINDALL && !f)
+  {
+    self->matches.l = 0;
+    fgroot_instance->backend.fgDirtyElement(*self);
+    return FG_ACCEPT;
+  }
+  if(!f || !f->find || self->mask != 0) // We don't let anyone search masked text.
+    return 0;
+  size_t findlen = f->findlen;
+  if(!findlen)
+    while(f->find[findlen] != 0) ++findlen;
+  bool nocase = (f->flags&FGTEXTBOX_FIND_IGNORECASE) != 0;
+
+  switch(action)
+  {
+  case FGTEXTBOX_FINDNEXT:
+  {
+    size_t i = fgTextbox_Search(self->text32.p, self->text32.l, bssmax(self->start, self->end), f->find, findlen, nocase);
+    if(i == (size_t)~0)
+      i = fgTextbox_Search(self->text32.p, self->text32.l, 0, f->find, findlen, nocase);
+    if(i == (size_t)~0)
+      return 0;
+    self->end = i;
+    self->start = i + findlen;
+    fgTextbox_fixpos(self, self->end, &self->endpos);
+    fgTextbox_fixpos(self, self->start, &self->startpos);
+    return FG_ACCEPT;
+  }
+  case FGTEXTBOX_FINDALL:
+  {
+    size_t n = fgTextbox_FindAll(self, f->find, findlen, nocase);
+    fgTextbox_FixMatches(self);
+    fgroot_instance->backend.fgDirtyElement(*self);
+    return n;
+  }
+  case FGTEXTBOX_REPLACEALL:
+  {
+    size_t n = fgTextbox_FindAll(self, f->find, findlen, nocase);
+    if(!n)
+      return 0;
+    size_t replacelen = f->replacelen;
+    if(!replacelen && f->replace != 0)
+      while(f->replace[replacelen] != 0) ++replacelen;
+
+    // Build the replacement for everything between the first and last match, so the whole operation is a single splice.
+    size_t begin = self->matches.p[0].start;
+    size_t end = self->matches.p[n - 1].end;
+    bss_util::cDynArray<int> text(end - begin - n*findlen + n*replacelen);
+    for(size_t i = 0; i < n; ++i)
+    {
+      for(size_t j = 0; j < replacelen; ++j)
+        text.Add(f->replace[j]);
+      size_t next = (i + 1 < n) ? self->matches.p[i + 1].start : end;
+      for(size_t j = self->matches.p[i].end; j < next; ++j)
+        text.Add(self->text32.p[j]);
+    }
+    fgTextbox_RecordEdit(self, begin, end - begin, text, text.Length());
+    fgTextbox_Splice(self, begin, end - begin, text, text.Length());
+    self->start = begin + text.Length();
+    fgTextbox_fixpos(self, self->start, &self->startpos);
+    fgTextbox_SetCursorEnd(self);
+    return n;
+  }
+  }
+  return 0;
+}
+
+inline void fgTextbox_DrawRange(fgTextbox* self, const AbsRect& area, AbsVec begin, AbsVec end, unsigned int color, fgDrawAuxData* data)
+{
+  CRect uv = CRect{ 0,0,0,0,0,0,0,0 };
+  AbsVec center = AbsVec{ 0,0 };
+  if(begin.y == end.y)
+  {
+    AbsRect srect = { area.left + begin.x, area.top + begin.y, area.left + end.x, area.top + begin.y + self->lineheight };
+    fgroot_instance->backend.fgDrawAsset(0, &uv, color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
+  }
+  else
+  {
+    AbsRect srect = AbsRect{ area.left + begin.x, area.top + begin.y, area.right, area.top + begin.y + self->lineheight };
+    fgroot_instance->backend.fgDrawAsset(0, &uv, color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
+    if(begin.y + self->lineheight + 0.5 < end.y)
+    {
+      srect = AbsRect{ area.left, area.top + begin.y + self->lineheight, area.right, area.top + end.y };
+      fgroot_instance->backend.fgDrawAsset(0, &uv, color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
+    }
+    srect = AbsRect{ area.left, area.top + end.y, area.left + end.x, area.top + end.y + self->lineheight };
+    fgroot_instance->backend.fgDrawAsset(0, &uv, color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
+  }
+}
+
 AbsVec fgTextbox_RelativeMouse(fgTextbox* self, const FG_Msg* msg)
 {
   AbsRect r;
@@ -167,10 +615,23 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
     memset(&self->placeholder8, 0, sizeof(fgVectorUTF8));
     memset(&self->placeholder16, 0, sizeof(fgVectorUTF16));
     memset(&self->placeholder32, 0, sizeof(fgVectorUTF32));
+    memset(&self->maskcache, 0, sizeof(fgVector));
+    memset(&self->linestarts, 0, sizeof(self->linestarts));
+    memset(&self->line8, 0, sizeof(fgVectorUTF8));
+    memset(&self->line16, 0, sizeof(fgVectorUTF16));
+    self->linelayout = 0;
+    fgTextbox_RebuildLines(self);
+    memset(&self->undolog, 0, sizeof(self->undolog));
+    memset(&self->undodata, 0, sizeof(fgVectorUTF32));
+    self->undoindex = 0;
+    self->undobudget = (1 << 20);
     self->validation = 0;
     self->formatting = 0;
     self->mask = 0;
+    self->maskadvance = -1.0f;
     self->selector.color = ~0;
+    self->highlight.color = 0x8000FFFF;
+    memset(&self->matches, 0, sizeof(self->matches));
     self->placecolor.color = ~0;
     self->cursorcolor.color = 0xFF000000;
     self->start = 0;
@@ -251,6 +712,14 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
       if(msg->IsCtrlDown())
         return _sendsubmsg<FG_ACTION>(*self, FGTEXTBOX_PASTE);
       break;
+    case FG_KEY_Z:
+      if(msg->IsCtrlDown())
+        return _sendsubmsg<FG_ACTION>(*self, msg->IsShiftDown() ? FGTEXTBOX_REDO : FGTEXTBOX_UNDO);
+      break;
+    case FG_KEY_Y:
+      if(msg->IsCtrlDown())
+        return _sendsubmsg<FG_ACTION>(*self, FGTEXTBOX_REDO);
+      break;
     case FG_KEY_PAGEUP:
     case FG_KEY_PAGEDOWN:
     {
@@ -327,6 +796,31 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
       case FGTEXTBOX_TOGGLEINSERT:
         self->inserting = !self->inserting;
         break;
+      case FGTEXTBOX_UNDO:
+        if(!fgTextbox_Undo(self))
+          return 0;
+        break;
+      case FGTEXTBOX_REDO:
+        if(!fgTextbox_Redo(self))
+          return 0;
+        break;
+      case FGTEXTBOX_CLEARUNDO:
+        fgTextbox_ClearUndo(self);
+        return FG_ACCEPT;
+      case FGTEXTBOX_FINDNEXT:
+      case FGTEXTBOX_FINDALL:
+      case FGTEXTBOX_REPLACEALL:
+      {
+        size_t r = fgTextbox_Find(self, msg->subtype, (const fgTextboxFind*)msg->p);
+        if(msg->subtype != FGTEXTBOX_FINDALL)
+          self->lastclick = fgroot_instance->time;
+        return r;
+      }
+      case FGTEXTBOX_SETUNDOBUDGET:
+        self->undobudget = msg->u;
+        if(self->undolog.l*sizeof(fgTextboxEdit) + self->undodata.l*sizeof(int) > self->undobudget)
+          fgTextbox_ClearUndo(self);
+        return FG_ACCEPT;
       default:
         return fgScrollbar_Message(&self->scroll, msg);
     }
@@ -335,6 +829,8 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
   case FG_SETTEXT:
     if(msg->subtype <= FGTEXTFMT_UTF32)
     {
+      fgTextbox_ClearUndo(self);
+      self->matches.l = 0;
       ((bss_util::cDynArray<int>*)&self->text32)->Clear();
       ((bss_util::cDynArray<wchar_t>*)&self->text16)->Clear();
       ((bss_util::cDynArray<char>*)&self->text8)->Clear();
@@ -381,10 +877,13 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
       break;
       case FGTEXTFMT_MASK:
         self->mask = msg->i;
+        self->maskcache.l = 0;
+        self->maskadvance = -1.0f;
         break;
       }
     }
     fgText_Conversion(FGTEXTFMT_UTF32, &self->text8, &self->text16, &self->text32); // the textbox requires a UTF32 format be available at all times
+    fgTextbox_RebuildLines(self);
     if(!(self->scroll->flags&FGELEMENT_SILENT))
       fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
     fgroot_instance->backend.fgDirtyElement(*self);
@@ -392,7 +891,9 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
   case FG_SETFONT:
   {
     if(self->layout != 0) fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, self->layout);
+    if(self->linelayout != 0) fgroot_instance->backend.fgFontLayout(self->font, 0, 0, 0, 0, 0, 0, self->linelayout);
     self->layout = 0;
+    self->linelayout = 0;
     void* oldfont = self->font; // We can't delete this up here because it may rely on the same font we're setting.
     self->font = 0;
     if(msg->p)
@@ -405,6 +906,7 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
       self->font = fgroot_instance->backend.fgCloneFont(msg->p, identical ? 0 : &desc);
     }
     if(oldfont) fgroot_instance->backend.fgDestroyFont(oldfont);
+    self->maskadvance = -1.0f;
 
     fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
     fgroot_instance->backend.fgDirtyElement(*self);
@@ -412,11 +914,15 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
     break;
   case FG_SETLINEHEIGHT:
     self->lineheight = msg->f;
+    self->maskadvance = -1.0f;
+    self->linelayoutline = (size_t)~0;
     fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
     fgroot_instance->backend.fgDirtyElement(*self);
     break;
   case FG_SETLETTERSPACING:
     self->letterspacing = msg->f;
+    self->maskadvance = -1.0f;
+    self->linelayoutline = (size_t)~0;
     fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTMOVE, self, FGMOVE_PROPAGATE | FGMOVE_RESIZE);
     fgroot_instance->backend.fgDirtyElement(*self);
     break;
@@ -427,6 +933,7 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
     case FGSETCOLOR_PLACEHOLDER: self->placecolor.color = (unsigned int)msg->i; break;
     case FGSETCOLOR_CURSOR: self->cursorcolor.color = (unsigned int)msg->i; break;
     case FGSETCOLOR_SELECT: self->selector.color = (unsigned int)msg->i; break;
+    case FGSETCOLOR_HIGHLIGHT: self->highlight.color = (unsigned int)msg->i; break;
     }
     fgroot_instance->backend.fgDirtyElement(*self);
     break;
@@ -456,6 +963,7 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
     case 1: return self->placecolor.color;
     case 2: return self->cursorcolor.color;
     case 3: return self->selector.color;
+    case FGSETCOLOR_HIGHLIGHT: return self->highlight.color;
     }
     assert(false);
   case FG_MOVE:
@@ -492,26 +1000,17 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
         end = self->startpos;
       }
 
-
-      CRect uv = CRect{ 0,0,0,0,0,0,0,0 };
-      AbsVec center = AbsVec{ 0,0 };
-      if(begin.y == end.y)
-      {
-        AbsRect srect = { area.left + begin.x, area.top + begin.y, area.left + end.x, area.top + begin.y + self->lineheight };
-        fgroot_instance->backend.fgDrawAsset(0, &uv, self->selector.color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
-      }
-      else
+      for(size_t i = 0; i < self->matches.l; ++i) // Matches are sorted, so we can stop once we're past the bottom of the clipping area
       {
-        AbsRect srect = AbsRect{ area.left + begin.x, area.top + begin.y, area.right, area.top + begin.y + self->lineheight };
-        fgroot_instance->backend.fgDrawAsset(0, &uv, self->selector.color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
-        if(begin.y + self->lineheight + 0.5 < end.y)
-        {
-          srect = AbsRect{ area.left, area.top + begin.y + self->lineheight, area.right, area.top + end.y };
-          fgroot_instance->backend.fgDrawAsset(0, &uv, self->selector.color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
-        }
-        srect = AbsRect{ area.left, area.top + end.y, area.left + end.x, area.top + end.y + self->lineheight };
-        fgroot_instance->backend.fgDrawAsset(0, &uv, self->selector.color, 0, 0, &srect, 0, &center, FGRESOURCE_RECT, data);
+        fgTextboxMatch& m = self->matches.p[i];
+        if(area.top + m.startpos.y > cliparea.bottom)
+          break;
+        if(area.top + m.endpos.y + self->lineheight >= cliparea.top)
+          fgTextbox_DrawRange(self, area, m.startpos, m.endpos, self->highlight.color, data);
       }
+      fgTextbox_DrawRange(self, area, begin, end, self->selector.color, data);
+
+      AbsVec center;
 
       // Draw text
       fgScaleRectDPI(&area, data->dpi.x, data->dpi.y);
@@ -530,11 +1029,9 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
       }
       else
       {
-        fgVector* v = fgText_Conversion(fgroot_instance->backend.BackendTextFormat, &self->text8, &self->text16, &self->text32);
+        fgVector* v = fgTextbox_GetDisplayText(self);
         text = v->p;
         len = v->l;
-        if(self->mask)
-          FILLMASK(self, text)
       }
 
       fgroot_instance->backend.fgDrawFont(self->font,
@@ -548,7 +1045,7 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
         &center,
         self->scroll.control.element.flags,
         data,
-        (self->mask != 0 || !self->text32.l) ? 0 : self->layout);
+        !self->text32.l ? 0 : self->layout);
 
       // Draw cursor
       if(fgFocusedWindow == *self && bss_util::bssfmod(fgroot_instance->time - self->lastclick, fgroot_instance->cursorblink * 2) < fgroot_instance->cursorblink)
@@ -612,13 +1109,14 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
         ResolveInnerRect(*self, &self->areacache);
         fgIntVec dpi = self->scroll->GetDPI(); // GetDPI can return 0 if we have no parent, which can happen when a layout is being set up or destroyed.
         fgScaleRectDPI(&self->areacache, dpi.x, dpi.y);
+        self->linelayoutline = (size_t)~0;
         AbsRect r = self->areacache;
         if(self->scroll->flags&FGELEMENT_EXPANDX) // If maxdim is -1, this will translate into a -1 maxdim for the text and properly deal with all resizing cases.
           r.right = r.left + self->scroll->maxdim.x;
         if(self->scroll->flags&FGELEMENT_EXPANDY)
           r.bottom = r.top + self->scroll->maxdim.y;
 
-        fgVector* v = fgText_Conversion(fgroot_instance->backend.BackendTextFormat, &self->text8, &self->text16, &self->text32);
+        fgVector* v = fgTextbox_GetDisplayText(self); // If we're masked, this lays out the masked text so draw can reuse the layout
         if(v)
           self->layout = fgroot_instance->backend.fgFontLayout(self->font, v->p, v->l, self->lineheight, self->letterspacing, &r, self->scroll->flags, self->layout);
         dim->x = r.right - r.left;
@@ -626,9 +1124,14 @@ size_t fgTextbox_Message(fgTextbox* self, const FG_Msg* msg)
         assert(!isnan(self->scroll.realsize.x) && !isnan(self->scroll.realsize.y));
         fgTextbox_fixpos(self, self->start, &self->startpos);
         fgTextbox_fixpos(self, self->end, &self->endpos);
+        fgTextbox_FixMatches(self);
       }
     }
     return 0;
+  case FG_SETFLAGS:
+    self->maskadvance = -1.0f; // Wrapping or alignment may have changed
+    self->linelayoutline = (size_t)~0;
+    break;
   case FG_SETDPI:
     (*self)->SetFont(self->font); // By setting the font to itself we'll clone it into the correct DPI
     break;
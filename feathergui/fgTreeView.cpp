@@ -6,6 +6,10 @@
 #include "bss-util/bss_util.h"
 #include "feathercpp.h"
 
+static const char* FGSTR_TREEVIEW = "TreeView";
+static const char* FGSTR_TREEITEM = "TreeItem";
+static const size_t FGTREEITEM_EXPANDED = ((size_t)1) << ((sizeof(size_t) << 3) - 1);
+
 size_t fgTreeItemArrow_Message(fgElement* self, const FG_Msg* msg)
 {
   switch(msg->type)
@@ -24,9 +28,9 @@ void fgTreeItem_Init(fgTreeItem* BSS_RESTRICT self, fgElement* BSS_RESTRICT pare
 }
 size_t fgTreeItem_Message(fgTreeItem* self, const FG_Msg* msg)
 {
-  static const char* CLASSNAME = "TreeItem";
+  static const char* CLASSNAME = FGSTR_TREEITEM;
   static const char* ARROWNAME = "TreeItem$arrow";
-  static const size_t EXPANDED = ((size_t)1) << ((sizeof(size_t) << 3) - 1);
+  static const size_t EXPANDED = FGTREEITEM_EXPANDED;
 
   switch(msg->type)
   {
@@ -35,6 +39,7 @@ size_t fgTreeItem_Message(fgTreeItem* self, const FG_Msg* msg)
     fgElement_Init(&self->arrow, &self->control.element, 0, ARROWNAME, FGELEMENT_BACKGROUND|FGELEMENT_HIDDEN, 0, 0);
     self->arrow.message = (fgMessage)&fgTreeItemArrow_Message;
     self->count = EXPANDED;
+    self->batch = 0;
     fgMaskSetStyle(&self->arrow, "visible", fgStyleGetMask("visible", "hidden"));
     return FG_ACCEPT;
   case FG_ADDITEM:
@@ -51,23 +56,19 @@ size_t fgTreeItem_Message(fgTreeItem* self, const FG_Msg* msg)
       self->arrow.SetFlag(FGELEMENT_HIDDEN, ((--self->count) & (~EXPANDED)) == 0);
     }
     break;
+  case FG_LAYOUTCHANGE:
+    if(self->batch > 0) // fgTreeItem_SetExpanded resets the layout once it's done
+      return FG_ACCEPT;
+    break;
   case FG_LAYOUTFUNCTION:
     return fgTileLayout(&self->control.element, (const FG_Msg*)msg->p, FGBOX_TILEY, (AbsVec*)msg->p2);
   case FG_ACTION:
     if(msg->subtype != 0) // If nonzero this action was meant for the root
       return !self->control.element.parent ? 0 : fgPassMessage(self->control.element.parent, msg);
+    if(self->control.element.parent != 0 && self->control.element.parent->GetClassName() == FGSTR_TREEVIEW && ((fgTreeview*)self->control.element.parent)->source.count != 0)
+      return _sendsubmsg<FG_ACTION, void*>(self->control.element.parent, FGTREEVIEW_TOGGLE, self); // Virtual items don't have children, so the treeview has to expand them
 
-    self->count = ((self->count&EXPANDED) ^ EXPANDED) | (self->count&(~EXPANDED));
-    fgMaskSetStyle(&self->arrow, (self->count&EXPANDED) ? "visible" : "hidden", fgStyleGetMask("visible", "hidden"));
-    {
-      fgElement* cur = self->control.element.root;
-      while(cur)
-      {
-        if(cur->GetClassName() == CLASSNAME)
-          cur->SetFlag(FGELEMENT_IGNORE | FGELEMENT_HIDDEN | FGELEMENT_BACKGROUND, !(self->count&EXPANDED));
-        cur = cur->next;
-      }
-    }
+    fgTreeItem_SetExpanded(self, !(self->count&EXPANDED), 0);
     return FG_ACCEPT;
   case FG_GETCLASSNAME:
     return (size_t)CLASSNAME;
@@ -86,6 +87,34 @@ size_t fgTreeItem_Message(fgTreeItem* self, const FG_Msg* msg)
   return fgControl_Message(&self->control, msg);
 }
 
+char fgTreeItem_SetExpanded(fgTreeItem* self, char expanded, char recursive)
+{
+  char changed = !(self->count&FGTREEITEM_EXPANDED) != !expanded;
+  if(!changed && !recursive)
+    return 0;
+
+  ++self->batch; // Children are finished before we lay ourselves out, so every item gets exactly one layout pass, from the bottom up.
+  for(fgElement* cur = self->control.element.root; cur != 0; cur = cur->next)
+  {
+    if(cur->GetClassName() != FGSTR_TREEITEM)
+      continue;
+    if(recursive && fgTreeItem_SetExpanded((fgTreeItem*)cur, expanded, recursive))
+      changed = 1;
+    if(!(self->count&FGTREEITEM_EXPANDED) != !expanded)
+      cur->SetFlag(FGELEMENT_IGNORE | FGELEMENT_HIDDEN | FGELEMENT_BACKGROUND, !expanded);
+  }
+  --self->batch;
+
+  if(!(self->count&FGTREEITEM_EXPANDED) != !expanded)
+  {
+    self->count = (expanded ? FGTREEITEM_EXPANDED : 0) | (self->count&(~FGTREEITEM_EXPANDED));
+    fgMaskSetStyle(&self->arrow, expanded ? "visible" : "hidden", fgStyleGetMask("visible", "hidden"));
+  }
+  if(changed && !self->batch)
+    _sendsubmsg<FG_LAYOUTCHANGE, void*, size_t>(&self->control.element, FGELEMENT_LAYOUTRESET, 0, 0);
+  return changed;
+}
+
 void fgTreeItem_Destroy(fgTreeItem* self)
 {
   self->control->message = (fgMessage)fgControl_Message;
@@ -97,20 +126,276 @@ void fgTreeview_Init(fgTreeview* BSS_RESTRICT self, fgElement* BSS_RESTRICT pare
 }
 void fgTreeview_Destroy(fgTreeview* self)
 {
+  ((bss_util::cDynArray<fgTreeRow>&)self->rows).~cDynArray();
+  ((bss_util::cDynArray<fgElement*>&)self->pool).~cDynArray();
   self->scrollbar->message = (fgMessage)fgScrollbar_Message;
   fgScrollbar_Destroy(&self->scrollbar);
 }
+inline FABS fgTreeview_RowHeight(fgTreeview* self) { return (self->fixedsize.y > 0) ? self->fixedsize.y : self->scrollbar->GetLineHeight(); }
+inline FABS fgTreeview_Indent(fgTreeview* self) { return (self->fixedsize.x >= 0) ? self->fixedsize.x : self->scrollbar->GetLineHeight(); }
+
+void fgTreeview_BindItem(fgTreeview* self, fgElement* item, size_t index)
+{
+  fgTreeRow& row = self->rows.p[index];
+  if(row.children == (size_t)~0)
+    row.children = self->source.count(self->source.user, row.node);
+  if(item->GetClassName() == FGSTR_TREEITEM) // Only real tree items have an arrow we can update
+  {
+    fgTreeItem* treeitem = (fgTreeItem*)item;
+    treeitem->count = row.expanded ? FGTREEITEM_EXPANDED : 0;
+    treeitem->arrow.SetFlag(FGELEMENT_HIDDEN, !row.children);
+    fgMaskSetStyle(&treeitem->arrow, row.expanded ? "visible" : "hidden", fgStyleGetMask("visible", "hidden"));
+  }
+  self->source.bind(self->source.user, item, row.node, row.depth);
+
+  FABS h = fgTreeview_RowHeight(self);
+  FABS x = row.depth*fgTreeview_Indent(self);
+  item->SetArea(CRect { x, 0, index*h, 0, 0, 1, (index + 1)*h, 0 });
+}
+
+// Makes sure exactly the rows in the viewport plus an overscan have an element, recycling elements that scrolled out of view.
+void fgTreeview_Realize(fgTreeview* self, bool rebind)
+{
+  static const size_t OVERSCAN = 4;
+  if(!self->source.count)
+    return;
+  bss_util::cDynArray<fgElement*>& pool = (bss_util::cDynArray<fgElement*>&)self->pool;
+  FABS h = fgTreeview_RowHeight(self);
+  AbsRect r;
+  ResolveRect(*self, &r);
+  FABS offset = self->scrollbar.realpadding.top - self->scrollbar->padding.top;
+  size_t start = (offset > 0) ? (size_t)(offset / h) : 0;
+  size_t end = (size_t)ceilf(bssmax(offset + r.bottom - r.top, 0.0f) / h);
+  start = (start > OVERSCAN) ? start - OVERSCAN : 0;
+  end = bssmin(end + OVERSCAN, self->rows.l);
+  if(start > end)
+    start = end;
+  if(!rebind && start == self->poolstart && end == self->poolstart + pool.Length())
+    return;
+
+  bss_util::cDynArray<fgElement*> items(end - start);
+  bss_util::cDynArray<fgElement*> recycle;
+  items.SetLength(end - start);
+  for(size_t i = 0; i < items.Length(); ++i)
+    items[i] = 0;
+  for(size_t i = 0; i < pool.Length(); ++i)
+  {
+    size_t index = self->poolstart + i;
+    if(!rebind && index >= start && index < end)
+      items[index - start] = pool[i];
+    else
+      recycle.Add(pool[i]);
+  }
+  for(size_t i = 0; i < items.Length(); ++i)
+  {
+    if(items[i] != 0)
+      continue;
+    if(recycle.Length() > 0)
+    {
+      items[i] = recycle.Back();
+      recycle.RemoveLast();
+    }
+    else
+      items[i] = fgroot_instance->backend.fgCreate(!self->source.type ? "TreeItem" : self->source.type, *self, 0, 0, 0, &fgTransform_EMPTY, 0);
+    fgTreeview_BindItem(self, items[i], start + i);
+  }
+  for(size_t i = 0; i < recycle.Length(); ++i)
+    VirtualFreeChild(recycle[i]);
+  pool = std::move(items);
+  self->poolstart = start;
+}
+
+// Rows have moved, so the scroll extents change and every element in the viewport has to be rebound.
+inline void fgTreeview_RowsChanged(fgTreeview* self)
+{
+  fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+  fgTreeview_Realize(self, true);
+  fgroot_instance->backend.fgDirtyElement(*self);
+}
+
+void fgTreeview_SetExpanded(fgTreeview* self, size_t row, char expanded)
+{
+  if(row >= self->rows.l || !self->rows.p[row].expanded == !expanded)
+    return;
+  bss_util::cDynArray<fgTreeRow>& rows = (bss_util::cDynArray<fgTreeRow>&)self->rows;
+  fgTreeRow& r = rows[row];
+  r.expanded = expanded;
+  if(expanded)
+  {
+    if(r.children == (size_t)~0)
+      r.children = self->source.count(self->source.user, r.node);
+    size_t n = r.children;
+    void* node = r.node;
+    size_t depth = r.depth + 1;
+    if(n > 0)
+    {
+      rows.Reserve(rows.Length() + n); // This can move the array, so r is invalid after this point
+      fgTreeRow* p = self->rows.p;
+      memmove(p + row + 1 + n, p + row + 1, (self->rows.l - row - 1) * sizeof(fgTreeRow));
+      for(size_t i = 0; i < n; ++i)
+        p[row + 1 + i] = fgTreeRow { self->source.child(self->source.user, node, i), depth, (size_t)~0, 0 };
+      self->rows.l += n;
+    }
+  }
+  else
+  {
+    size_t end = row + 1;
+    while(end < self->rows.l && self->rows.p[end].depth > r.depth)
+      ++end;
+    if(end > row + 1)
+    {
+      bss_util::RemoveRangeSimple<fgTreeRow>(self->rows.p, self->rows.l, row + 1, end - row - 1);
+      self->rows.l -= end - row - 1;
+    }
+  }
+  fgTreeview_RowsChanged(self);
+}
+
+// Appends every descendant of node to rows in display order, expanding all of them.
+void fgTreeview_AppendExpanded(fgTreeview* self, bss_util::cDynArray<fgTreeRow>& rows, void* node, size_t depth)
+{
+  size_t n = self->source.count(self->source.user, node);
+  for(size_t i = 0; i < n; ++i)
+  {
+    void* child = self->source.child(self->source.user, node, i);
+    size_t children = self->source.count(self->source.user, child);
+    rows.Add(fgTreeRow { child, depth, children, 1 });
+    if(children > 0)
+      fgTreeview_AppendExpanded(self, rows, child, depth + 1);
+  }
+}
+
+void fgTreeview_SetExpandedAll(fgTreeview* self, char expanded)
+{
+  if(self->source.count != 0) // Rebuild the row array in a single pass instead of splicing it once per node
+  {
+    bss_util::cDynArray<fgTreeRow>& rows = (bss_util::cDynArray<fgTreeRow>&)self->rows;
+    if(expanded)
+    {
+      rows.Clear();
+      fgTreeview_AppendExpanded(self, rows, 0, 0);
+    }
+    else
+    {
+      size_t j = 0;
+      for(size_t i = 0; i < rows.Length(); ++i)
+        if(!rows[i].depth)
+        {
+          rows[j] = rows[i];
+          rows[j++].expanded = 0;
+        }
+      rows.SetLength(j);
+    }
+    return fgTreeview_RowsChanged(self);
+  }
+
+  char changed = 0;
+  ++self->batch;
+  for(fgElement* cur = self->scrollbar->root; cur != 0; cur = cur->next)
+    if(cur->GetClassName() == FGSTR_TREEITEM && fgTreeItem_SetExpanded((fgTreeItem*)cur, expanded, 1))
+      changed = 1;
+  --self->batch;
+  if(changed && !self->batch)
+    fgSubMessage(*self, FG_LAYOUTCHANGE, FGELEMENT_LAYOUTRESET, 0, 0);
+}
+
+void fgTreeview_Refresh(fgTreeview* self)
+{
+  bss_util::cDynArray<fgTreeRow>& rows = (bss_util::cDynArray<fgTreeRow>&)self->rows;
+  rows.Clear();
+  if(self->source.count != 0)
+  {
+    size_t n = self->source.count(self->source.user, 0);
+    rows.Reserve(n);
+    for(size_t i = 0; i < n; ++i)
+      rows.Add(fgTreeRow { self->source.child(self->source.user, 0, i), 0, (size_t)~0, 0 });
+  }
+  fgTreeview_RowsChanged(self);
+}
+
+void fgTreeview_SetSource(fgTreeview* self, const fgTreeSource* source)
+{
+  bss_util::cDynArray<fgElement*>& pool = (bss_util::cDynArray<fgElement*>&)self->pool;
+  for(size_t i = 0; i < pool.Length(); ++i)
+    VirtualFreeChild(pool[i]);
+  pool.Clear();
+  self->poolstart = 0;
+  if(source != 0)
+    self->source = *source;
+  else
+    memset(&self->source, 0, sizeof(fgTreeSource));
+  fgTreeview_Refresh(self);
+}
+
 size_t fgTreeview_Message(fgTreeview* self, const FG_Msg* msg)
 {
   switch(msg->type)
   {
   case FG_CONSTRUCT:
     fgScrollbar_Message(&self->scrollbar, msg);
+    memset(&self->source, 0, sizeof(fgTreeSource));
+    memset(&self->rows, 0, sizeof(self->rows));
+    memset(&self->pool, 0, sizeof(fgVectorElement));
+    self->poolstart = 0;
+    self->fixedsize.x = -1;
+    self->fixedsize.y = -1;
+    self->batch = 0;
+    return FG_ACCEPT;
+  case FG_LAYOUTCHANGE:
+    if(self->batch > 0)
+      return FG_ACCEPT;
+    break;
+  case FG_ACTION:
+    if(msg->subtype == FGTREEVIEW_TOGGLE)
+    {
+      for(size_t i = 0; i < self->pool.l; ++i)
+        if(self->pool.p[i] == msg->e)
+        {
+          fgTreeview_SetExpanded(self, self->poolstart + i, !self->rows.p[self->poolstart + i].expanded);
+          return FG_ACCEPT;
+        }
+      return 0;
+    }
+  case FG_MOVE: // Any scrollbar action or resize can change which rows are in the viewport
+    if(self->source.count != 0)
+    {
+      size_t r = fgScrollbar_Message(&self->scrollbar, msg);
+      fgTreeview_Realize(self, false);
+      return r;
+    }
+    break;
+  case FG_SETDIM:
+    if(msg->subtype != FGDIM_FIXED)
+      break;
+    self->fixedsize.x = msg->f;
+    self->fixedsize.y = msg->f2;
+    fgTreeview_RowsChanged(self);
     return FG_ACCEPT;
+  case FG_GETDIM:
+    if(msg->subtype == FGDIM_FIXED)
+      return (size_t)&self->fixedsize;
+    break;
+  case FG_GETITEM:
+    if(self->source.count != 0)
+    {
+      if(msg->subtype == FGITEM_COUNT)
+        return self->rows.l;
+      return (msg->u >= self->poolstart && msg->u - self->poolstart < self->pool.l) ? (size_t)self->pool.p[msg->u - self->poolstart] : 0;
+    }
+    break;
   case FG_LAYOUTFUNCTION:
+    if(self->source.count != 0) // A virtualized treeview's rows are placed explicitly
+    {
+      if(msg->p2 != 0)
+      {
+        ((AbsVec*)msg->p2)->x = 0;
+        ((AbsVec*)msg->p2)->y = self->rows.l*fgTreeview_RowHeight(self);
+      }
+      return 0;
+    }
     return fgTileLayout(*self, (const FG_Msg*)msg->p, FGBOX_TILEY, (AbsVec*)msg->p2);
   case FG_GETCLASSNAME:
-    return (size_t)"TreeView";
+    return (size_t)FGSTR_TREEVIEW;
   case FG_GOTFOCUS:
     if(fgElement_CheckLastFocus(*self)) // try to resolve via lastfocus
       return FG_ACCEPT;
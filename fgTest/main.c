@@ -5,6 +5,7 @@
 #include "fgWindow.h"
 #include "fgRoot.h"
 #include "fgLayout.h"
+#include "fgList.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -102,39 +103,149 @@ RETPAIR test_Window()
   ENDTEST;
 }
 
-//char test_root_STAGE=0;
-//char donothing(void* a) { test_root_STAGE=2; return 1; } // Returning one auto deallocates the node
-//char dontfree(void* a) { test_root_STAGE=1; return 0; } // Returning zero means the node won't be automatically deallocated
+static char test_root_STAGE=0;
+static char test_root_ORDER[8];
+static size_t test_root_N=0;
+static fgDeferAction* test_root_SELF=0;
+static char donothing(void* a) { test_root_STAGE=2; return 1; } // Returning one auto deallocates the node
+static char dontfree(void* a) { test_root_STAGE=1; return 0; } // Returning zero means the node won't be automatically deallocated
+static char record(void* a) { test_root_ORDER[test_root_N++]=(char)(size_t)a; return 1; }
+static char checkremoved(void* a) { test_root_STAGE=(test_root_SELF->heapindex==(size_t)-1) ? 3 : 4; return 1; } // The action must already be out of the heap when it's called
+
+static char test_root_HeapValid(fgRoot* root)
+{
+  size_t i;
+  for(i = 0; i < root->updateheap.l; ++i)
+  {
+    if(root->updateheap.p[i]->heapindex != i)
+      return 0;
+    if(i > 0 && root->updateheap.p[(i - 1)/2]->time > root->updateheap.p[i]->time)
+      return 0;
+  }
+  return 1;
+}
+
+static fgElement test_listen_ELEMENTS[3];
+static size_t test_listen_COUNT[3];
+static void test_listener(fgElement* self, const FG_Msg* msg) { ++test_listen_COUNT[self - test_listen_ELEMENTS]; }
+static const unsigned short test_listen_TYPES[] = { FG_GETCLASSNAME, FG_GETNAME, FG_GETSTYLE, FG_GETVALUE, FG_GETCOLOR, FG_GETOUTLINE, FG_GETFONT, FG_GETLETTERSPACING };
+static const size_t test_listen_NUMTYPES = sizeof(test_listen_TYPES)/sizeof(unsigned short);
+
+static void test_listen_SendAll()
+{
+  size_t i, j;
+  for(i = 0; i < 3; ++i)
+    for(j = 0; j < test_listen_NUMTYPES; ++j)
+      fgVoidMessage(test_listen_ELEMENTS + i, test_listen_TYPES[j], 0, 0);
+}
 
 RETPAIR test_Root()
 {
   BEGINTEST;
-  /*fgWindow* top;
-  fgDeferAction* action = fgRoot_AllocAction(&donothing,0,5);
-  fgDeferAction* action2 = fgRoot_AllocAction(&dontfree,0,2);
-
-  gui = (fgRoot*)malloc(sizeof(fgRoot));
-  AbsRect area = { 0 };
-  fgRoot_Init(gui, &area, 0, 0);
-  top = (fgWindow*)fgWindow_Create("test",0,1,0);
-
-  fgRoot_AddAction(gui,action);
-  fgRoot_AddAction(gui,action2);
-  (*gui->update)(gui,1);
+  fgRoot* root = fgSingleton();
+  double now = root->time;
+  size_t i, j;
+
+  fgDeferAction* action = fgRoot_AllocAction(&donothing,0,now+5);
+  fgDeferAction* action2 = fgRoot_AllocAction(&dontfree,0,now+2);
+  TEST(action!=action2);
+  TEST(action->heapindex==(size_t)-1);
+  fgRoot_AddAction(root,action);
+  fgRoot_AddAction(root,action2);
+  TEST(root->updateheap.p[0]==action2);
+  fgRoot_Update(root,1);
   TEST(test_root_STAGE==0);
-  (*gui->update)(gui,1);
+  fgRoot_Update(root,1);
   TEST(test_root_STAGE==1);
-  fgRoot_DeallocAction(gui,action2);
-  (*gui->update)(gui,1);
+  TEST(action2->heapindex==(size_t)-1);
+  fgRoot_DeallocAction(root,action2);
+  fgRoot_Update(root,1);
   TEST(test_root_STAGE==1);
-  (*gui->update)(gui,10);
+  fgRoot_Update(root,10);
   TEST(test_root_STAGE==2);
-  fgVoidMessage((fgControl*)top,FG_ADDCHILD,fgButton_Create(fgResource_Create("fake"),0,0,2,0));
-  fgVoidMessage((fgControl*)top,FG_ADDCHILD,top->region.root->root);
-  fgVoidMessage((fgControl*)top,FG_ADDCHILD,fgButton_Create(fgLoadText("fake",0,"arial.ttf",14,0),0,0,4,0));
-  fgVoidMessage((fgControl*)top,FG_ADDCHILD,fgLoadImage("fake"));
-  //fgStatic_Message(top->region.rlist,FG_RADDCHILD,fgLoadText("fake",0,"arial.ttf",14,0),0);
-  //fgVoidMessage((fgControl*)top,FG_ADDCHILD,top->region.rlist->transform.root);*/
+  TEST(root->updateheap.l==0);
+
+  action = fgRoot_AllocAction(&donothing,0,0); // Deallocated actions are reused first
+  fgRoot_DeallocAction(root,action);
+  TEST(fgRoot_AllocAction(&donothing,0,0)==action);
+  fgRoot_DeallocAction(root,action);
+
+  now = root->time;
+  {
+    fgDeferAction* a1 = fgRoot_AllocAction(&record,(void*)1,now+5);
+    fgDeferAction* a2 = fgRoot_AllocAction(&record,(void*)2,now+1);
+    fgDeferAction* a3 = fgRoot_AllocAction(&record,(void*)3,now+3);
+    fgDeferAction* a4 = fgRoot_AllocAction(&record,(void*)4,now+4);
+    fgDeferAction* a5 = fgRoot_AllocAction(&record,(void*)5,now+2);
+    fgRoot_AddAction(root,a1);
+    fgRoot_AddAction(root,a2);
+    fgRoot_AddAction(root,a3);
+    fgRoot_AddAction(root,a4);
+    fgRoot_AddAction(root,a5);
+    TEST(root->updateheap.l==5);
+    TEST(root->updateheap.p[0]==a2);
+    TEST(test_root_HeapValid(root));
+    fgRoot_RemoveAction(root,a3); // Remove from the middle
+    TEST(a3->heapindex==(size_t)-1);
+    TEST(root->updateheap.l==4);
+    TEST(test_root_HeapValid(root));
+    fgRoot_DeallocAction(root,a3);
+    a1->time = now+0.5;
+    fgRoot_ModifyAction(root,a1);
+    TEST(root->updateheap.p[0]==a1);
+    TEST(test_root_HeapValid(root));
+    a1->time = now+1.5; // Moving it back down has to work as well
+    fgRoot_ModifyAction(root,a1);
+    TEST(root->updateheap.p[0]==a2);
+    TEST(test_root_HeapValid(root));
+    fgRoot_DeallocAction(root,a4); // Deallocating an action still in the heap removes it
+    TEST(root->updateheap.l==3);
+    TEST(test_root_HeapValid(root));
+    fgRoot_Update(root,10);
+    TEST(test_root_N==3);
+    TEST(test_root_ORDER[0]==2);
+    TEST(test_root_ORDER[1]==1);
+    TEST(test_root_ORDER[2]==5);
+    TEST(root->updateheap.l==0);
+  }
+
+  test_root_SELF = fgRoot_AllocAction(&checkremoved,0,root->time+1);
+  fgRoot_ModifyAction(root,test_root_SELF); // Inserts it, because it isn't in the heap yet
+  TEST(test_root_SELF->heapindex==0);
+  fgRoot_Update(root,2);
+  TEST(test_root_STAGE==3);
+
+  {
+    size_t (*hook)(fgElement*, const FG_Msg*) = root->backend.behaviorhook; // Listeners are only called through the listener hook
+    root->backend.behaviorhook = &fgBehaviorHookListener;
+    for(i = 0; i < 3; ++i)
+      fgElement_Init(test_listen_ELEMENTS + i, 0, 0, 0, 0, 0, 0);
+    for(j = 0; j < test_listen_NUMTYPES; ++j) // Interleaved so the keys of different elements collide and share probe chains
+      for(i = 0; i < 3; ++i)
+        fgElement_AddListener(test_listen_ELEMENTS + i, test_listen_TYPES[j], &test_listener);
+    fgElement_AddListener(test_listen_ELEMENTS, FG_GETNAME, &test_listener); // A second listener on the same key
+    test_listen_SendAll();
+    TEST(test_listen_COUNT[0]==test_listen_NUMTYPES + 1);
+    TEST(test_listen_COUNT[1]==test_listen_NUMTYPES);
+    TEST(test_listen_COUNT[2]==test_listen_NUMTYPES);
+
+    fgElement_ClearListeners(test_listen_ELEMENTS + 1); // Deleting from the middle of every probe chain must not hide the entries after it
+    test_listen_SendAll();
+    TEST(test_listen_COUNT[0]==(test_listen_NUMTYPES + 1)*2);
+    TEST(test_listen_COUNT[1]==test_listen_NUMTYPES);
+    TEST(test_listen_COUNT[2]==test_listen_NUMTYPES*2);
+
+    fgElement_AddListener(test_listen_ELEMENTS + 1, FG_GETNAME, &test_listener);
+    fgElement_ClearListeners(test_listen_ELEMENTS);
+    test_listen_SendAll();
+    TEST(test_listen_COUNT[0]==(test_listen_NUMTYPES + 1)*2);
+    TEST(test_listen_COUNT[1]==test_listen_NUMTYPES + 1);
+    TEST(test_listen_COUNT[2]==test_listen_NUMTYPES*3);
+
+    for(i = 0; i < 3; ++i)
+      fgElement_Destroy(test_listen_ELEMENTS + i);
+    root->backend.behaviorhook = hook;
+  }
   ENDTEST;
 }
 
@@ -144,9 +255,59 @@ RETPAIR test_Button()
   ENDTEST;
 }
 
+static char test_list_Ranges(fgList* list, const fgListRange* ranges, size_t n)
+{
+  size_t i;
+  if(list->selection.l != n)
+    return 0;
+  for(i = 0; i < n; ++i)
+    if(list->selection.p[i].start != ranges[i].start || list->selection.p[i].end != ranges[i].end)
+      return 0;
+  return 1;
+}
+
 RETPAIR test_List()
 {
   BEGINTEST;
+  static const char* ITEMS[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+  fgList* list = (fgList*)fgCreate("list", &fgSingleton()->gui.element, 0, 0, FGBOX_TILEY | FGLIST_MULTISELECT, &fgTransform_DEFAULT, 0);
+  fgElement* item;
+
+  TEST(fgElement_AddItems((fgElement*)list, ITEMS, 10)==10);
+  TEST(list->box.order.ordered.l==10);
+
+  fgList_SelectRange(list, 2, 5, 1);
+  { fgListRange r[] = { { 2, 5 } }; TEST(test_list_Ranges(list, r, 1)); }
+  fgList_SelectRange(list, 5, 7, 1); // Touching ranges are merged
+  { fgListRange r[] = { { 2, 7 } }; TEST(test_list_Ranges(list, r, 1)); }
+  fgList_SelectRange(list, 3, 4, 0); // Deselecting the middle splits it
+  { fgListRange r[] = { { 2, 3 }, { 4, 7 } }; TEST(test_list_Ranges(list, r, 2)); }
+  TEST(!fgList_IsSelected(list, 3));
+  TEST(fgList_IsSelected(list, 4));
+  fgList_InvertRange(list, 0, 5);
+  { fgListRange r[] = { { 0, 2 }, { 3, 4 }, { 5, 7 } }; TEST(test_list_Ranges(list, r, 3)); }
+
+  fgCreate("element", (fgElement*)list, list->box.order.ordered.p[1], 0, 0, &fgTransform_EMPTY, 0); // Inserting into a range splits it and shifts everything after it
+  { fgListRange r[] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 8 } }; TEST(test_list_Ranges(list, r, 4)); }
+  item = list->box.order.ordered.p[2];
+  TEST(fgElement_RemoveItemElements((fgElement*)list, &item, 1)==1); // Removing the only item in a range removes the range
+  { fgListRange r[] = { { 0, 1 }, { 3, 4 }, { 5, 7 } }; TEST(test_list_Ranges(list, r, 3)); }
+  item = list->box.order.ordered.p[4];
+  TEST(fgElement_RemoveItemElements((fgElement*)list, &item, 1)==1); // Removing the unselected item between two ranges joins them
+  { fgListRange r[] = { { 0, 1 }, { 3, 6 } }; TEST(test_list_Ranges(list, r, 2)); }
+  TEST(list->box.order.ordered.l==9);
+
+  {
+    fgListRange r[] = { { 1, 2 }, { 4, 5 } };
+    fgList_SetSelection(list, r, 2);
+    TEST(test_list_Ranges(list, r, 2));
+  }
+  fgList_ClearSelection(list);
+  TEST(list->selection.l==0);
+  TEST(list->styled==0); // Nothing can still look selected
+
+  item = (fgElement*)list;
+  fgElement_RemoveItemElements(&fgSingleton()->gui.element, &item, 1);
   ENDTEST;
 }
 
@@ -143,6 +143,12 @@ enum FGMOVE
   FGMOVE_MARGIN = (1 << 9),
 };
 
+enum FGADDCHILD
+{
+  FGADDCHILD_DEFAULT = 0,
+  FGADDCHILD_DEFER, // Doesn't apply the skin or send FG_MOVE to the child. Whoever sends this has to do both once it's done adding children.
+};
+
 enum FGTEXTFMT
 {
   FGTEXTFMT_UTF8 = 0,
@@ -177,6 +183,7 @@ enum FGSETCOLOR
   FGSETCOLOR_ROWEDGE,
   FGSETCOLOR_COLUMNEDGE,
   FGSETCOLOR_ROWEVEN,
+  FGSETCOLOR_HIGHLIGHT,
 };
 
 enum FGDIM
@@ -248,6 +255,8 @@ enum FGITEM
   FGITEM_COLUMN,
   FGITEM_LOCATION,
   FGITEM_COUNT,
+  FGITEM_TEXTARRAY, // Adds an array of UTF8 strings in one operation. Pass the array and its length.
+  FGITEM_ELEMENTARRAY, // Adds or removes an array of elements in one operation. Pass the array and its length.
 };
 
 enum FGVALUE
@@ -0,0 +1,55 @@
+// Copyright 2017 Black Sphere Studios
+// For conditions of distribution and use, see copyright notice in "feathergui.h"
+
+#ifndef __FG_ANIMATION_H__
+#define __FG_ANIMATION_H__
+
+#include "fgElement.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+  enum FGANIMATION_PROPERTY
+  {
+    FGANIMATION_AREA = 0, // Pass in a CRect
+    FGANIMATION_MARGIN, // Pass in an AbsRect
+    FGANIMATION_PADDING, // Pass in an AbsRect
+    FGANIMATION_COLOR, // Pass in an fgColor. The subtype is sent along with FG_SETCOLOR to pick which color is animated.
+  };
+
+  enum FGANIMATION_EASING
+  {
+    FGANIMATION_LINEAR = 0,
+    FGANIMATION_EASEIN,
+    FGANIMATION_EASEOUT,
+    FGANIMATION_EASEINOUT,
+  };
+
+  // A single animated property. Every value is stored as up to 8 floats so all tweens can be interpolated the same way, no matter what property they animate.
+  typedef struct _FG_TWEEN {
+    float from[8];
+    float delta[8]; // end - from
+    float value[8]; // Most recently interpolated value
+    fgElement* target;
+    double start; // Root time when the tween started
+    float duration; // In seconds
+    unsigned short property;
+    unsigned short subtype;
+    unsigned char easing;
+  } fgTween;
+
+  typedef fgDeclareVector(fgTween, Tween) fgVectorTween;
+
+  // Animates a property of target from its current value to end over duration seconds, replacing any animation already running on the same property.
+  FG_EXTERN void fgAnimate(fgElement* target, unsigned short property, unsigned short subtype, const void* end, float duration, unsigned char easing);
+  // Stops animating a property of target, leaving it wherever it currently is. Pass (unsigned short)-1 to stop every animation on target.
+  FG_EXTERN void fgAnimation_Stop(fgElement* target, unsigned short property);
+  // Advances every animation to the root's current time and applies the results. Called by fgRoot_Update.
+  FG_EXTERN void fgAnimation_Update(fgVectorTween* tweens, double time);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
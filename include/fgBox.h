@@ -27,7 +27,10 @@ enum FGBOX_FLAGS
 struct _FG_BOX_ORDERED_ELEMENTS_ {
   char isordered; // If we detect that a BACKGROUND element was inserted in the middle of the foreground elements, we disable fgOrderedDraw until all children are removed.
   fgVectorElement ordered; // Used to implement fgOrderedDraw if TILEX or TILEY layouts are used.
-  AbsVec fixedsize;
+  AbsVec fixedsize; // If positive, the size of every item along the layout axis, which lets virtualized lists calculate positions arithmetically. Set using FG_SETDIM with FGDIM_FIXED.
+  unsigned short batch; // Nonzero while items are being added in bulk. Layout changes are ignored until the batch ends, which then does a single layout pass.
+  char removing; // Set while children are removed in bulk. Each removal leaves a NULL hole in ordered, and the array is compacted once at the end.
+  fgVectorElement deferred; // Children added during a batch. Their skin and position are applied once the batch ends.
 };
 // A List is an arbitrary list of items with a number of different layout options that are selectable and/or draggable.
 typedef struct _FG_BOX_ {
@@ -44,6 +47,10 @@ FG_EXTERN void fgBox_Init(fgBox* self, fgElement* BSS_RESTRICT parent, fgElement
 FG_EXTERN void fgBox_Destroy(fgBox* self);
 FG_EXTERN size_t fgBox_Message(fgBox* self, const FG_Msg* msg);
 FG_EXTERN void fgBoxOrderedElement_Destroy(struct _FG_BOX_ORDERED_ELEMENTS_* self);
+FG_EXTERN size_t fgBoxOrderedElement_GetVisible(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgFlag flags, const AbsRect* area, const AbsRect* cache); // Returns the index of the first ordered element that could be inside area, where cache is the parent's area.
+FG_EXTERN void fgBoxOrderedElement_BeginBatch(struct _FG_BOX_ORDERED_ELEMENTS_* self, size_t reserve); // Suspends layout changes and reserves room for reserve more ordered elements.
+FG_EXTERN void fgBoxOrderedElement_EndBatch(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element); // Once the outermost batch ends, resets the layout of element.
+FG_EXTERN size_t fgBoxOrderedElement_RemoveItems(struct _FG_BOX_ORDERED_ELEMENTS_* self, fgElement* element, fgElement** items, size_t n); // Frees every item that is a child of element in a single batch. Returns how many were freed.
 FG_EXTERN size_t fgBoxOrderedElement_Message(struct _FG_BOX_ORDERED_ELEMENTS_* self, const FG_Msg* msg, fgElement* element, fgMessage callback);
 
 #ifdef  __cplusplus
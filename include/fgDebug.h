@@ -63,6 +63,7 @@ typedef struct _FG_DEBUG {
   fgTreeview elements; // TreeView of the elements, minus the debug view itself.
   fgTreeview messages; // Log of all messages passing through the GUI
   fgGrid properties; // element properties
+  fgGrid profile; // Timing statistics gathered by fgProfile, filled in by fgDebug_ShowProfile
   fgText contents; // message contents
   fgMenu context;
   size_t(*behaviorhook)(struct _FG_ELEMENT* self, const FG_Msg* msg);
@@ -95,7 +96,51 @@ FG_EXTERN size_t fgDebug_LogMessage(fgDebug* self, const FG_Msg* msg, unsigned l
 FG_EXTERN ptrdiff_t fgDebug_WriteMessage(char* buf, size_t bufsize, fgDebugMessage* msg);
 FG_EXTERN void fgDebug_DumpMessages(const char* file);
 FG_EXTERN void fgDebug_BuildTree(fgElement* treeview);
+FG_EXTERN void fgDebug_ShowProfile(fgDebug* self); // Fills the profile grid with the current fgProfile statistics, most expensive first, and shows it.
 
 FG_EXTERN size_t fgRoot_BehaviorDebug(fgElement* self, const FG_Msg* msg);
 
+// A compact binary record of a single message, written by the trace hook. Element names aren't stored, so the element is only an identifier.
+typedef struct _FG_TRACE_RECORD {
+  unsigned long long time; // Nanoseconds since fgTrace_Start was called
+  unsigned long long element; // Address of the element the message was sent to
+  unsigned int duration; // Nanoseconds spent handling the message, clamped to 0xFFFFFFFF
+  unsigned int result; // Lower 32 bits of the value the message returned
+  unsigned short type;
+  unsigned short subtype;
+  unsigned int depth; // How many messages were being handled when this one was sent
+} fgTraceRecord;
+
+// The trace is a fixed size ring buffer that is cheap enough to leave running in production. It never allocates: the buffer is provided by the
+// caller, its capacity must be a power of two, and once it's full the oldest records are overwritten.
+FG_EXTERN void fgTrace_Start(fgTraceRecord* buffer, size_t capacity);
+FG_EXTERN void fgTrace_Stop();
+// Writes a 16 byte header ("FGTR", the record size as a 32-bit integer, and the total number of records ever written as a 64-bit integer)
+// followed by the raw records still in the buffer, oldest first. Returns the number of records written.
+FG_EXTERN size_t fgTrace_Dump(const char* file);
+FG_EXTERN size_t fgRoot_BehaviorTrace(fgElement* self, const FG_Msg* msg);
+
+enum FGPROFILE_CONSTANTS
+{
+  FGPROFILE_BUCKETS = 32, // Bucket i of a histogram counts the calls that took between 2^i and 2^(i+1) nanoseconds.
+  FGPROFILE_MAXDEPTH = 256, // Messages nested deeper than this are still counted, but their exclusive time includes their children.
+};
+
+// Timing statistics for one message type sent to one control class. Times are in nanoseconds.
+typedef struct _FG_PROFILE_STAT {
+  unsigned long long count;
+  unsigned long long inclusive; // Total time spent handling the message, including any messages it sent
+  unsigned long long exclusive; // Total time spent handling the message, minus any messages it sent
+  unsigned int histogram[FGPROFILE_BUCKETS];
+} fgProfileStat;
+
+// The profiler wraps the current behavior hook and accumulates an fgProfileStat for every (control class, message type) pair. Control classes are
+// told apart by their message function and named with FG_GETCLASSNAME. If interval is positive, the statistics are reset every interval seconds.
+FG_EXTERN void fgProfile_Start(double interval);
+FG_EXTERN void fgProfile_Stop();
+FG_EXTERN void fgProfile_Reset();
+// Calls fn for every (control class, message type) pair that was sent at least one message since the last reset. Custom events are all counted as FG_CUSTOMEVENT.
+FG_EXTERN void fgProfile_Iterate(void* p, void(*fn)(void*, const char* classname, unsigned short type, const fgProfileStat* stat));
+FG_EXTERN size_t fgRoot_BehaviorProfile(fgElement* self, const FG_Msg* msg);
+
 #endif
\ No newline at end of file
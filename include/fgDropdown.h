@@ -4,7 +4,7 @@
 #ifndef __FG_DROPDOWN_H__
 #define __FG_DROPDOWN_H__
 
-#include "fgBox.h"
+#include "fgList.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -19,6 +19,7 @@ typedef struct {
   fgColor select;
   char dropflag;
   fgMouseState mouse;
+  fgTypeahead typeahead;
 #ifdef  __cplusplus
   inline operator fgElement*() { return &control.element; }
   inline fgElement* operator->() { return operator fgElement*(); }
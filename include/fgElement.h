@@ -38,6 +38,7 @@ struct _FG_ELEMENT;
 struct _FG_STYLE;
 struct _FG_SKIN;
 struct _FG_LAYOUT;
+struct _FG_DISPATCH_TABLE;
 struct __kh_fgUserdata_t;
 typedef fgDeclareVector(struct _FG_ELEMENT*, Element) fgVectorElement;
 
@@ -78,6 +79,9 @@ typedef struct _FG_ELEMENT {
   struct _FG_ELEMENT* nextnoclip;
   struct _FG_ELEMENT* prevnoclip;
   struct _FG_ELEMENT* lastfocus; // Stores the last child that had focus, if any. This never points to the child that CURRENTLY has focus, only to the child that HAD focus.
+  size_t orderindex; // Position of this element in its parent's ordered array, if the parent keeps one (see fgBox).
+  const struct _FG_DISPATCH_TABLE* dispatch; // Cached dispatch table for the current message function. Rechecked whenever message changes.
+  unsigned long long listeners; // Bit (type % 64) is set if this element might have a listener for that message type, so most messages can skip the listener lookup.
 
 #ifdef  __cplusplus
   FG_DLLEXPORT void Construct();
@@ -218,7 +222,12 @@ FG_EXTERN void ResolveNoClipRect(const fgElement* self, AbsRect* out);
 FG_EXTERN char MsgHitElement(const FG_Msg* msg, const fgElement* element);
 FG_EXTERN void VirtualFreeChild(fgElement* self);
 FG_EXTERN void fgElement_Clear(fgElement* self);
+FG_EXTERN size_t fgElement_AddItems(fgElement* self, const char** items, size_t n); // Adds n text items in one batch if the element supports it, otherwise adds them one at a time. Returns how many were added.
+FG_EXTERN size_t fgElement_AddItemElements(fgElement* self, fgElement** items, size_t n); // Same as above for an array of elements.
+FG_EXTERN size_t fgElement_RemoveItemElements(fgElement* self, fgElement** items, size_t n); // Frees n children in one batch if the element supports it, otherwise frees them one at a time. Returns how many were freed.
+FG_EXTERN void fgElement_ReorderChildren(fgElement* self, fgElement* const* children, size_t n, fgElement* next); // Moves n foreground children so they appear in the given order right before next, then sends a single FGELEMENT_LAYOUTREORDER.
 FG_EXTERN void fgElement_MouseMoveCheck(fgElement* self);
+FG_EXTERN char fgElement_PotentialResize(fgElement* self); // Returns the FGMOVE flags a change in this element's parent can cause for it.
 FG_EXTERN void fgElement_AddListener(fgElement* self, unsigned short type, fgListener listener);
 
 #ifdef  __cplusplus
@@ -21,9 +21,22 @@ extern "C" {
     FGGRID_RESIZECOLUMN = FGSCROLLBAR_NUM,
   };
 
+  enum FGGRID_SORT
+  {
+    FGGRID_SORT_TEXT = 0, // Compares the UTF8 text of each cell byte by byte.
+    FGGRID_SORT_NUMBER = 1, // Parses the text of each cell as a number.
+    FGGRID_SORT_DESCENDING = 2,
+  };
+
+  typedef int(*fgGridCompare)(fgElement* a, fgElement* b, void* user); // Returns negative, zero or positive like strcmp. Either cell can be NULL if its row is missing that column.
+
   typedef struct _FG_GRID_ROW {
     fgElement element;
     struct _FG_BOX_ORDERED_ELEMENTS_ order;
+    fgVectorElement cells; // In a virtualized grid, cells.p[i] displays column cellstart + i of this row. Unused otherwise.
+    size_t cellstart;
+    size_t index; // Row this element is currently bound to in a virtualized grid.
+    size_t trackversion; // Grid track version the cells were last placed with. Rows that are out of view are only re-placed once they scroll into view.
 #ifdef  __cplusplus
     inline operator fgElement*() { return &element; }
     inline fgElement* operator->() { return operator fgElement*(); }
@@ -36,6 +49,20 @@ extern "C" {
 #endif
   } fgGridRow;
 
+  // Supplies the cells of a virtualized grid. Columns still come from the header, but rows and cells are only created for the visible area, and are recycled as the grid scrolls.
+  typedef struct _FG_GRID_SOURCE {
+    size_t(*rows)(void* user); // Returns the number of rows in the grid.
+    void(*bind)(void* user, fgElement* cell, size_t column, size_t row); // Sets up a (possibly recycled) element so it displays the given cell.
+    void* user;
+    const char* type; // Class of the cell elements to create. If NULL, "Text" is used.
+  } fgGridSource;
+
+  // Position and size of a single column, shared by every row.
+  typedef struct _FG_GRID_TRACK {
+    FABS offset; // Combined width of every column before this one.
+    FABS width;
+  } fgGridTrack;
+
   // Represents a grid of columns (or rows) with labels.
   typedef struct _FG_GRID {
     fgList list;
@@ -44,6 +71,11 @@ extern "C" {
     fgColor rowedgecolor;
     fgColor columnedgecolor;
     fgColor rowevencolor;
+    fgGridSource source; // If source.rows is set, the grid is virtualized.
+    fgDeclareVector(fgGridTrack, GridTrack) tracks; // Column widths from the header, shared by every row so cells can be placed without asking the header about each one.
+    size_t colstart; // Range of columns that currently have cells in a virtualized grid.
+    size_t colend;
+    size_t trackversion; // Incremented whenever the tracks change.
 #ifdef  __cplusplus
     inline operator fgElement*() { return &list.box.scroll.control.element; }
     inline fgElement* operator->() { return operator fgElement*(); }
@@ -57,12 +89,16 @@ extern "C" {
     FG_DLLEXPORT fgElement* GetItem(size_t column, size_t row);
     FG_DLLEXPORT fgGridRow* GetRow(size_t row);
     FG_DLLEXPORT fgElement* GetColumn(size_t column);
+    FG_DLLEXPORT void Sort(size_t column, char flags = FGGRID_SORT_TEXT, fgGridCompare compare = 0, void* user = 0);
 #endif
   } fgGrid;
 
   FG_EXTERN void fgGrid_Init(fgGrid* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
   FG_EXTERN void fgGrid_Destroy(fgGrid* self);
   FG_EXTERN size_t fgGrid_Message(fgGrid* self, const FG_Msg* msg);
+  FG_EXTERN void fgGrid_SetSource(fgGrid* self, const fgGridSource* source); // Virtualizes the grid using the given data source. Pass NULL to remove it. Rows added with InsertRow aren't supported while a source is set.
+  FG_EXTERN void fgGrid_Refresh(fgGrid* self); // Queries the source for the row count again and rebinds every visible cell.
+  FG_EXTERN void fgGrid_Sort(fgGrid* self, size_t column, char flags, fgGridCompare compare, void* user); // Stably sorts the rows by a column, using compare instead of the built-in comparison if it isn't NULL. A virtualized grid should sort its data source instead.
 
   FG_EXTERN void fgGridRow_Init(fgGridRow* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
   FG_EXTERN size_t fgGridRow_Message(fgGridRow* self, const FG_Msg* msg);
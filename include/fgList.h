@@ -5,6 +5,7 @@
 #define __FG_LIST_H__
 
 #include "fgBox.h"
+#include "fgText.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -17,18 +18,57 @@ enum FGLIST_FLAGS
   FGLIST_DRAGGABLE = (FGLIST_SELECT << 2),
 };
 
+// A range of selected item indices, from start up to but not including end.
+typedef struct _FG_LIST_RANGE {
+  size_t start;
+  size_t end;
+} fgListRange;
+
+// Supplies the items of a virtualized list. Only the items that are visible get an element, and those elements are recycled as the list scrolls.
+typedef struct _FG_LIST_SOURCE {
+  size_t(*count)(void* user); // Returns the number of items in the list.
+  void(*bind)(void* user, fgElement* item, size_t index); // Sets up a (possibly recycled) element so it displays the item at index.
+  void* user;
+  const char* type; // Class of the item elements to create. If NULL, "ListItem" is used.
+} fgListSource;
+
+// One item in a type-ahead index. The key is the item's case-folded text, stored at offset in the key buffer.
+typedef struct _FG_TYPEAHEAD_ENTRY {
+  size_t offset;
+  fgElement* item;
+} fgTypeaheadEntry;
+
+// Lets the user jump to an item by typing the start of its text. Added items are keyed the next time a key is typed, and removed items drop their entry, so the sorted index is only rebuilt when it's found to be stale.
+typedef struct _FG_TYPEAHEAD {
+  fgDeclareVector(fgTypeaheadEntry, TypeaheadEntry) entries; // Sorted by key, then by child order.
+  fgVectorUTF8 keys;
+  fgVectorUTF8 prefix; // Case-folded text typed so far.
+  fgVectorElement pending; // Items added since the last search.
+  size_t garbage; // Bytes in keys that belong to removed entries.
+  struct _FG_DEFER_ACTION* timeout; // Clears the prefix once the user stops typing.
+  char dirty; // Set this if an item's text changes so the index is rebuilt.
+} fgTypeahead;
+
 // A List is an arbitrary list of items with a number of different layout options that are selectable and/or draggable.
 typedef struct {
   fgBox box;
   fgColor select; // color index 0
   fgColor hover; // color index 1
   fgColor drag; // color index 2
-  fgVectorElement selected; // vector of all selected elements
+  fgDeclareVector(fgListRange, ListRange) selection; // Sorted, non-overlapping ranges of selected item indices.
+  size_t anchor; // Index that shift-clicking selects from
   fgMouseState mouse;
   FABS splitter; // If nonzero, determines the width (or height) of the area between elements that allows you to resize them. Set using SETVALUE
   fgElement* split;
   FABS splitedge;
   int splitmouse;
+  fgListSource source; // If source.count is set, the list is virtualized and its items come from the source instead of its children.
+  fgVectorElement pool; // Elements bound to the items that are currently visible. pool.p[i] displays item poolstart + i.
+  size_t poolstart;
+  size_t count; // Number of items the source reported the last time the list was refreshed.
+  FABS itemsize; // Size of each item along the layout axis. Comes from FGDIM_FIXED, or is estimated from the first item if that isn't set.
+  fgTypeahead typeahead;
+  size_t styled; // Number of items the list has given the "selected" style, so it can skip restyling when nothing is or looks selected.
 #ifdef  __cplusplus
   inline operator fgElement*() { return &box.scroll.control.element; }
   inline fgElement* operator->() { return operator fgElement*(); }
@@ -38,6 +78,19 @@ typedef struct {
 FG_EXTERN void fgList_Init(fgList* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
 FG_EXTERN void fgList_Destroy(fgList* self);
 FG_EXTERN size_t fgList_Message(fgList* self, const FG_Msg* msg);
+FG_EXTERN void fgList_SetSource(fgList* self, const fgListSource* source); // Virtualizes the list using the given data source. Pass NULL to remove it. Any existing children are left alone, so a virtualized list should otherwise be empty.
+FG_EXTERN char fgList_IsSelected(fgList* self, size_t index);
+FG_EXTERN void fgList_SelectRange(fgList* self, size_t start, size_t end, char select); // Selects or deselects every item from start up to but not including end.
+FG_EXTERN void fgList_InvertRange(fgList* self, size_t start, size_t end);
+FG_EXTERN void fgList_ClearSelection(fgList* self);
+FG_EXTERN void fgList_SetSelection(fgList* self, const fgListRange* ranges, size_t n); // Replaces the selection with n sorted, non-overlapping ranges, restyling the items only once.
+FG_EXTERN void fgList_Refresh(fgList* self); // Queries the source for the item count again and rebinds every visible item. Call this whenever the underlying data changes.
+
+FG_EXTERN void fgTypeahead_Init(fgTypeahead* self);
+FG_EXTERN void fgTypeahead_Destroy(fgTypeahead* self);
+FG_EXTERN void fgTypeahead_Add(fgTypeahead* self, fgElement* item); // Call when item is added to the parent being searched.
+FG_EXTERN void fgTypeahead_Remove(fgTypeahead* self, fgElement* item); // Call when item is removed from the parent being searched.
+FG_EXTERN fgElement* fgTypeahead_Search(fgTypeahead* self, fgBox* parent, int keychar); // Adds keychar to the typed prefix and returns the first child of parent, in sorted order, whose text starts with it.
 
 FG_EXTERN void fgListItem_Init(fgControl* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
 FG_EXTERN size_t fgListItem_Message(fgControl* self, const FG_Msg* msg);
@@ -0,0 +1,61 @@
+// Copyright 2017 Black Sphere Studios
+// For conditions of distribution and use, see copyright notice in "feathergui.h"
+
+#ifndef __FG_LOGVIEW_H__
+#define __FG_LOGVIEW_H__
+
+#include "fgScrollbar.h"
+#include "fgText.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define FGLOGVIEW_CHUNKLINES 256
+
+// A fixed-size block of lines in a log view. Every chunk except the last one is always full.
+typedef struct _FG_LOG_CHUNK {
+  fgVectorUTF8 text; // Every line in this chunk back to back, in the backend text format. This is measured in bytes regardless of the format.
+  size_t count; // Number of lines in this chunk
+  size_t version; // Measurement version y was calculated with. If this doesn't match the log view's version, y is stale and the chunk's height is an estimate.
+  size_t offsets[FGLOGVIEW_CHUNKLINES + 1]; // Byte offset of each line in text
+  float y[FGLOGVIEW_CHUNKLINES + 1]; // Offset of each line from the top of the chunk
+} fgLogChunk;
+
+// A log view is an append-only list of lines inside a scrollbar, designed for tailing logs that grow without bound. Lines are stored in chunks,
+// and only the visible lines are ever laid out, so appending and drawing don't depend on how many lines it holds.
+typedef struct {
+  fgScrollbar scroll;
+  fgDeclareVector(fgLogChunk*, LogChunk) chunks;
+  fgDeclareVector(float, LogHeight) heights; // heights.p[i] is the combined height of every chunk before chunk i, so there is always one more height than there are chunks.
+  fgLogChunk* spare; // A chunk released by the max-lines ring, kept so the next append doesn't have to allocate one.
+  size_t first; // Index of the first line in the first chunk that hasn't been dropped.
+  size_t count; // Number of lines
+  size_t dropped; // Total number of lines ever dropped, which gives every line a stable ID for the layout cache.
+  size_t maxlines; // If not zero, the oldest lines are dropped once there are more than this. Set using FG_SETRANGE.
+  fgDeclareVector(void*, LogLayout) layouts; // Cached layouts for the visible lines, starting at line ID layoutstart.
+  size_t layoutstart;
+  float width; // The width lines are wrapped to.
+  float maxwidth; // The widest line that has been laid out so far.
+  size_t version; // Incremented whenever something that affects line heights changes, so chunks are remeasured only once they are looked at.
+  void* font;
+  fgColor color;
+  float lineheight;
+  float letterspacing;
+#ifdef  __cplusplus
+  inline operator fgElement*() { return &scroll.control.element; }
+  inline fgElement* operator->() { return operator fgElement*(); }
+#endif
+} fgLogView;
+
+FG_EXTERN void fgLogView_Init(fgLogView* self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
+FG_EXTERN void fgLogView_Destroy(fgLogView* self);
+FG_EXTERN size_t fgLogView_Message(fgLogView* self, const FG_Msg* msg);
+FG_EXTERN void fgLogView_Append(fgLogView* self, const char* text, size_t len); // Appends UTF8 text, splitting it into lines. If len is zero, text must be null terminated.
+FG_EXTERN void fgLogView_Clear(fgLogView* self);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
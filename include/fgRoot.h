@@ -6,6 +6,7 @@
 
 #include "fgControl.h"
 #include "fgBackend.h"
+#include "fgAnimation.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -21,11 +22,13 @@ struct _FG_SKIN;
 typedef void(*fgInitializer)(fgElement* BSS_RESTRICT, fgElement* BSS_RESTRICT, fgElement* BSS_RESTRICT, const char*, fgFlag, const fgTransform*, unsigned short);
 
 typedef struct _FG_DEFER_ACTION {
-  struct _FG_DEFER_ACTION* next; // It's crucial that this is the first element
-  struct _FG_DEFER_ACTION* prev;
   char (*action)(void*); // If this returns nonzero, this node is deallocated after this returns.
-  void* arg; // Argument passed into the function
+  union {
+    void* arg; // Argument passed into the function
+    struct _FG_DEFER_ACTION* nextfree; // Next unused action in the root's pool
+  };
   double time; // Time when the action should be triggered
+  size_t heapindex; // Position in the root's action heap, or (size_t)-1 if it isn't scheduled.
 } fgDeferAction;
 
 // Defines the root interface to the GUI. This object should be returned by the implementation at some point
@@ -33,7 +36,9 @@ typedef struct _FG_ROOT {
   fgControl gui;
   fgBackend backend;
   struct _FG_MONITOR* monitors;
-  fgDeferAction* updateroot;
+  fgDeclareVector(fgDeferAction*, DeferAction) updateheap; // Binary min-heap of scheduled actions, ordered by time
+  struct __VECTOR__DeferAction actionblocks; // Every block of actions the pool has allocated, all freed at once when the root is destroyed.
+  fgDeferAction* actionfree; // Unused actions, linked through nextfree
   struct __kh_fgRadioGroup_t* radiohash;
   struct __kh_fgFunctionMap_t* functionhash;
   struct __kh_fgIDMap_t* idmap;
@@ -52,7 +57,8 @@ typedef struct _FG_ROOT {
   fgElement* dragdraw;
   fgElement* topmost;
   unsigned int keys[8]; // 8*4*8 = 256
-  void* aniroot;
+  fgVectorTween animations; // Active animations, all advanced together by fgRoot_Update
+  fgDeclareVector(FG_Msg, InputMsg) inputqueue; // Input events added by fgRoot_QueueInject, waiting for fgRoot_Update
 #ifdef  __cplusplus
   inline bool GetKey(unsigned char key) const { return (keys[key / 32] & (1 << (key % 32))) != 0; }
   inline operator fgElement*() { return &gui.element; }
@@ -65,13 +71,17 @@ FG_EXTERN void fgRoot_Init(fgRoot* self, const AbsRect* area, const fgIntVec* dp
 FG_EXTERN void fgRoot_Destroy(fgRoot* self);
 FG_EXTERN size_t fgRoot_Message(fgRoot* self, const FG_Msg* msg);
 FG_EXTERN size_t fgRoot_Inject(fgRoot* self, const FG_Msg* msg); // Returns 0 if handled, 1 otherwise
+// Queues an input event to be injected during the next fgRoot_Update instead of right away. Consecutive mouse moves (and touch moves for the same
+// touch) are merged into the last one, and consecutive scroll events have their deltas added together, so a backend with a high polling rate only
+// costs one hit test per frame. Everything else stays in the order it was queued.
+FG_EXTERN void fgRoot_QueueInject(fgRoot* self, const FG_Msg* msg);
 FG_EXTERN void fgRoot_Update(fgRoot* self, double delta);
 FG_EXTERN void fgRoot_CheckMouseMove(fgRoot* self);
-FG_EXTERN fgDeferAction* fgRoot_AllocAction(char (*action)(void*), void* arg, double time);
-FG_EXTERN void fgRoot_DeallocAction(fgRoot* self, fgDeferAction* action); // Removes action from the list if necessary
-FG_EXTERN void fgRoot_AddAction(fgRoot* self, fgDeferAction* action); // Adds an action. Action can't already be in list.
-FG_EXTERN void fgRoot_RemoveAction(fgRoot* self, fgDeferAction* action); // Removes an action. Action must be in list.
-FG_EXTERN void fgRoot_ModifyAction(fgRoot* self, fgDeferAction* action); // Moves action if it needs to be moved, or inserts it if it isn't already in the list.
+FG_EXTERN fgDeferAction* fgRoot_AllocAction(char (*action)(void*), void* arg, double time); // Actions come from a pool owned by the root, so they can't outlive it.
+FG_EXTERN void fgRoot_DeallocAction(fgRoot* self, fgDeferAction* action); // Removes action from the heap if necessary and returns it to the pool
+FG_EXTERN void fgRoot_AddAction(fgRoot* self, fgDeferAction* action); // Adds an action. Action can't already be in the heap.
+FG_EXTERN void fgRoot_RemoveAction(fgRoot* self, fgDeferAction* action); // Removes an action. Action must be in the heap.
+FG_EXTERN void fgRoot_ModifyAction(fgRoot* self, fgDeferAction* action); // Moves action if its time changed, or inserts it if it isn't already in the heap.
 FG_EXTERN struct _FG_MONITOR* fgRoot_GetMonitor(const fgRoot* self, const AbsRect* rect);
 FG_EXTERN fgElement* fgRoot_GetID(fgRoot* self, const char* id);
 FG_EXTERN void fgRoot_AddID(fgRoot* self, const char* id, fgElement* element);
@@ -85,7 +95,13 @@ FG_EXTERN fgElement* fgCreate(const char* type, fgElement* BSS_RESTRICT parent,
 FG_EXTERN int fgRegisterCursor(int cursor, const void* data, size_t sz);
 FG_EXTERN int fgRegisterFunction(const char* name, fgListener fn);
 FG_EXTERN void fgRegisterControl(const char* name, fgInitializer fn, size_t sz);
+// Lets messages skip straight past handlers that would only pass them to their parent. types must list every message type that message handles
+// itself (including any it only inspects before calling parent), and every other type must be passed to parent unchanged. Register parents first.
+FG_EXTERN void fgRegisterDispatch(fgMessage message, fgMessage parent, const unsigned short* types, size_t count);
 FG_EXTERN void fgIterateControls(void* p, void(*fn)(void*, const char*));
+// Sends n messages to self, but holds back the FG_MOVE, layout and dirty notifications self generates until the end, where each is sent once.
+// Returns how many of the messages returned a nonzero value.
+FG_EXTERN size_t fgSendMsgBatch(fgElement* self, const FG_Msg* msgs, size_t n);
 FG_EXTERN size_t fgGetTypeSize(const char* type);
 
 #ifdef  __cplusplus
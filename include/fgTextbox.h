@@ -28,8 +28,43 @@ enum FGTEXTBOX_ACTIONS
   FGTEXTBOX_GOTOLINESTART,
   FGTEXTBOX_GOTOLINEEND,
   FGTEXTBOX_TOGGLEINSERT,
+  FGTEXTBOX_UNDO,
+  FGTEXTBOX_REDO,
+  FGTEXTBOX_CLEARUNDO,
+  FGTEXTBOX_SETUNDOBUDGET, // Sets the maximum size of the undo history in bytes. Zero disables it.
+  FGTEXTBOX_FINDNEXT, // Selects the next match after the cursor, wrapping around to the beginning. Pass in an fgTextboxFind.
+  FGTEXTBOX_FINDALL, // Highlights every match and returns how many there were. Pass in an fgTextboxFind, or NULL to remove the highlights.
+  FGTEXTBOX_REPLACEALL, // Replaces every match with the replacement string as a single undoable edit, and returns how many there were.
 };
 
+enum FGTEXTBOX_FIND_FLAGS
+{
+  FGTEXTBOX_FIND_IGNORECASE = 1, // Folds ASCII letters before comparing them.
+};
+
+typedef struct _FG_TEXTBOX_FIND {
+  const int* find; // UTF32 string to search for
+  size_t findlen; // If zero, find must be null terminated
+  const int* replace; // UTF32 replacement string, only used by FGTEXTBOX_REPLACEALL
+  size_t replacelen; // If zero, replace must be null terminated
+  char flags;
+} fgTextboxFind;
+
+typedef struct {
+  size_t start;
+  size_t end;
+  AbsVec startpos;
+  AbsVec endpos;
+} fgTextboxMatch;
+
+// A single entry in the undo history, which replaced "removed" code points at "offset" with "inserted" code points.
+typedef struct {
+  size_t offset;
+  size_t removed;
+  size_t inserted;
+  size_t data; // index into undodata, where the removed text is immediately followed by the inserted text.
+} fgTextboxEdit;
+
 // A Textbox is really just a text static inside an optional Scrollbar. It can be single or multi-line with an optional validation regex.
 // The textbox only understands single UTF codepoints, so an external library should be used to perform unicode normalization before setting it.
 typedef struct {
@@ -37,15 +72,24 @@ typedef struct {
   char* validation; // validation regex
   char* formatting; // printf formatting string matched to capture groups in the validation regex
   int mask; // If not zero, stores a unicode character for password masking. 
+  fgVector maskcache; // Masked text in the backend text format. Every character is identical, so it is only refilled when the length or mask changes.
+  float maskadvance; // Advance of a single mask character. Negative if it hasn't been calculated for the current font yet, zero if the mask isn't laid out on a single fixed-width line.
   fgVectorUTF8 text8;
   fgVectorUTF16 text16;
   fgVectorUTF32 text32;
+  fgDeclareVector(size_t, LineStart) linestarts; // Code-point offset of the start of each line in text32, so caret queries only have to ask the backend about a single line.
+  fgVectorUTF8 line8; // Backend-format copy of the line being queried.
+  fgVectorUTF16 line16;
+  void* linelayout; // Layout of a single line, reused by caret queries until they move to another line or the text changes.
+  size_t linelayoutline; // Line that linelayout was built for, or -1 if it has to be rebuilt.
   fgVectorUTF8 placeholder8;
   fgVectorUTF16 placeholder16;
   fgVectorUTF32 placeholder32; // placeholder text displayed when textbox is empty.
   fgColor placecolor; // placeholder text color. Use SETCOLOR with the subtype set to 1.
   fgColor cursorcolor; // cursor color. Use SETCOLOR with the subtype set to 2.
   fgColor selector; // Color of the selector rectangle. Use SETCOLOR with the subtype set to 3.
+  fgColor highlight; // Color of find highlights. Use SETCOLOR with the subtype set to FGSETCOLOR_HIGHLIGHT.
+  fgDeclareVector(fgTextboxMatch, TextboxMatch) matches; // Highlighted results of the last FGTEXTBOX_FINDALL. Cleared whenever the text changes.
   size_t start; // current cursor
   AbsVec startpos;
   size_t end; // end of selection
@@ -59,6 +103,10 @@ typedef struct {
   float lineheight;
   float letterspacing;
   double lastclick; // determines the starting point of the cursor blink animation
+  fgDeclareVector(fgTextboxEdit, TextboxEdit) undolog;
+  fgVectorUTF32 undodata;
+  size_t undoindex; // Number of edits in undolog that are currently applied. Anything past this can be redone.
+  size_t undobudget; // Maximum size of undolog and undodata in bytes. Use FGTEXTBOX_SETUNDOBUDGET to change it.
 #ifdef  __cplusplus
   inline operator fgElement*() { return &scroll.control.element; }
   inline fgElement* operator->() { return operator fgElement*(); }
@@ -10,15 +10,45 @@
 extern "C" {
 #endif
 
+enum FGTREEVIEW_ACTIONS
+{
+  FGTREEVIEW_TOGGLE = FGSCROLLBAR_NUM, // Sent by a tree item in a virtualized treeview when its arrow is clicked.
+};
+
+// Supplies the nodes of a virtualized treeview. Nodes are opaque handles, and NULL is the (invisible) root whose children are the top level rows.
+// Children are only requested when their parent is expanded, and only the rows inside the viewport get an element.
+typedef struct _FG_TREE_SOURCE {
+  size_t(*count)(void* user, void* node); // Returns the number of children of node.
+  void*(*child)(void* user, void* node, size_t index); // Returns the child of node at index.
+  void(*bind)(void* user, fgElement* item, void* node, size_t depth); // Sets up a (possibly recycled) tree item so it displays the given node.
+  void* user;
+  const char* type; // Class of the row elements to create. If NULL, "TreeItem" is used.
+} fgTreeSource;
+
+// A single visible row of a virtualized treeview.
+typedef struct _FG_TREE_ROW {
+  void* node;
+  size_t depth;
+  size_t children; // Cached number of children, or -1 if it hasn't been requested yet.
+  char expanded;
+} fgTreeRow;
+
 typedef struct _FG_TREEITEM {
   fgControl control;
   fgElement arrow;
   size_t count;
+  unsigned short batch; // Nonzero while this item's children are being expanded or collapsed in bulk. Layout changes are ignored until it finishes.
 } fgTreeItem;
 
 // A treeview visualizes a tree structure as a series of nested lists. 
 typedef struct _FG_TREEVIEW {
   fgScrollbar scrollbar;
+  fgTreeSource source; // If source.count is set, the treeview is virtualized.
+  fgDeclareVector(fgTreeRow, TreeRow) rows; // Every row that would be visible if the viewport was infinitely tall, in order. Expanding or collapsing a node splices its descendants in or out.
+  fgVectorElement pool; // Elements bound to the rows that are currently in the viewport. pool.p[i] displays rows.p[poolstart + i].
+  size_t poolstart;
+  AbsVec fixedsize; // Indentation per level (x) and height of each row (y) in a virtualized treeview. Set using FG_SETDIM with FGDIM_FIXED.
+  unsigned short batch; // Nonzero during fgTreeview_SetExpandedAll, which does a single layout pass at the end.
 #ifdef  __cplusplus
   inline operator fgElement*() { return &scrollbar.control.element; }
   inline fgElement* operator->() { return operator fgElement*(); }
@@ -28,10 +58,15 @@ typedef struct _FG_TREEVIEW {
 FG_EXTERN void fgTreeview_Init(fgTreeview* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
 FG_EXTERN void fgTreeview_Destroy(fgTreeview* self);
 FG_EXTERN size_t fgTreeview_Message(fgTreeview* self, const FG_Msg* msg);
+FG_EXTERN void fgTreeview_SetSource(fgTreeview* self, const fgTreeSource* source); // Virtualizes the treeview using the given data source, collapsing everything. Pass NULL to remove it.
+FG_EXTERN void fgTreeview_Refresh(fgTreeview* self); // Rebuilds the top level rows from the source, collapsing everything.
+FG_EXTERN void fgTreeview_SetExpanded(fgTreeview* self, size_t row, char expanded); // Expands or collapses a row of a virtualized treeview.
+FG_EXTERN void fgTreeview_SetExpandedAll(fgTreeview* self, char expanded); // Expands or collapses every node in the tree, virtualized or not.
 
 FG_EXTERN void fgTreeItem_Init(fgTreeItem* BSS_RESTRICT self, fgElement* BSS_RESTRICT parent, fgElement* BSS_RESTRICT next, const char* name, fgFlag flags, const fgTransform* transform, unsigned short units);
 FG_EXTERN size_t fgTreeItem_Message(fgTreeItem* self, const FG_Msg* msg);
 FG_EXTERN void fgTreeItem_Destroy(fgTreeItem* self);
+FG_EXTERN char fgTreeItem_SetExpanded(fgTreeItem* self, char expanded, char recursive); // Expands or collapses an item, and all its descendants if recursive is set, with one layout pass per changed item. Returns nonzero if anything changed.
 
 #ifdef  __cplusplus
 }